@@ -0,0 +1,376 @@
+#include "batchenvironment.h"
+#include "blastkernel.h"
+#include "gamerandom.h"
+#include "openmask.h"
+
+//steps on the table in each direction (Up, Right, Down, Left)
+static const int stepX[4] = {-1, 0, 1, 0};
+static const int stepY[4] = {0, 1, 0, -1};
+//the direction of a new enemy, by a random number in [0,4) (as in GameModel::createEnemies)
+static const quint8 startFacing[4] = {GameModel::Up, GameModel::Down, GameModel::Left, GameModel::Right};
+
+
+//Allocates the state of all games at once; nothing is allocated by reset() and step() later.
+BatchEnvironment::BatchEnvironment(int count, const GameModel::Params &params, int threads, const BlastStencil &stencil):
+    n(count), _size(params.size), cells(params.size * params.size), maxEnemies(qMax(1, params.enemynum)),
+    stencil(stencil), _params(params), steps(0), finished(0)
+{
+    tileStore.resize(n * cells);
+    pXStore.resize(n);
+    pYStore.resize(n);
+    eXStore.resize(n * maxEnemies);
+    eYStore.resize(n * maxEnemies);
+    eFacingStore.resize(n * maxEnemies);
+    eCountStore.resize(n);
+    waitingStore.resize(n);
+    delayStore.resize(n);
+    tXStore.resize(n);
+    tYStore.resize(n);
+    timeStore.resize(n);
+    tickStore.resize(n);
+    rngStore.resize(n);
+    diedStore.resize(n);
+    rewardStore.resize(n);
+    doneStore.resize(n);
+    winStore.resize(n);
+
+    tileData = tileStore.data();
+    pX = pXStore.data();
+    pY = pYStore.data();
+    eX = eXStore.data();
+    eY = eYStore.data();
+    eFacing = eFacingStore.data();
+    eCount = eCountStore.data();
+    waiting = waitingStore.data();
+    delay = delayStore.data();
+    tX = tXStore.data();
+    tY = tYStore.data();
+    time = timeStore.data();
+    tick = tickStore.data();
+    rng = rngStore.data();
+    died = diedStore.data();
+    reward = rewardStore.data();
+    done = doneStore.data();
+    won = winStore.data();
+
+    stepFunction = selectStepFunction(params.destroywalls);
+
+    //a few chunks per worker, so that the workers finishing early can help out
+    int workers = threads > 0 ? threads : QThread::idealThreadCount();
+    pool.setMaxThreadCount(workers);
+    int chunkCount = workers > 1 ? qMin(n, workers * 4) : 1;
+    for (int c = 0; c < chunkCount; c++){
+        Chunk* chunk = new Chunk();
+        chunk->setAutoDelete(false);
+        chunk->env = this;
+        chunk->begin = n * c / chunkCount;
+        chunk->end = n * (c + 1) / chunkCount;
+        chunk->heatmap = 0;
+        chunks.append(chunk);
+    }
+
+    for (int e = 0; e < n; e++) resetGame(e, quint32(e + 1));
+}
+
+BatchEnvironment::~BatchEnvironment(){
+    pool.waitForDone();
+    foreach(Chunk* chunk, chunks){
+        delete chunk->heatmap;
+        delete chunk;
+    }
+}
+
+
+//The heatmaps are allocated here, so counting allocates nothing during the steps.
+void BatchEnvironment::setHeatmapsEnabled(bool on){
+    foreach(Chunk* chunk, chunks){
+        if (on && !chunk->heatmap) chunk->heatmap = new TileHeatmap(_size);
+        else if (on) chunk->heatmap->clear();
+        else {
+            delete chunk->heatmap;
+            chunk->heatmap = 0;
+        }
+    }
+}
+
+
+void BatchEnvironment::collectHeatmap(TileHeatmap &out) const{
+    if (out.size() != _size) out.resize(_size);
+    foreach(const Chunk* chunk, chunks){
+        if (chunk->heatmap) out.merge(*chunk->heatmap);
+    }
+}
+
+
+void BatchEnvironment::reset(const quint32* seeds){
+    for (int e = 0; e < n; e++) resetGame(e, seeds[e]);
+    steps = 0;
+    finished = 0;
+}
+
+
+//Steps every game; with more than one chunk, the chunks are run on the thread pool.
+BatchEnvironment::StepResult BatchEnvironment::step(const quint8* actions){
+    if (chunks.size() == 1){
+        (this->*stepFunction)(actions, 0, n, chunks[0]->heatmap);
+    } else {
+        foreach(Chunk* chunk, chunks){
+            chunk->actions = actions;
+            pool.start(chunk);
+        }
+        pool.waitForDone();
+    }
+
+    steps += n;
+    for (int e = 0; e < n; e++) finished += done[e];
+
+    StepResult result = {reward, done, won, tileData};
+    return result;
+}
+
+
+
+//-----RULES-----
+
+//Creates a new game in slot 'e', exactly like GameModel::reset does (same random numbers in the same order).
+void BatchEnvironment::resetGame(int e, quint32 seed){
+    const int N = _size;
+    quint8* t = tileData + e * cells;
+    for (int i = 0; i < N; ++i){
+        for (int j = 0; j < N; ++j){
+            t[i*N + j] = (i==0 || j == 0 || i == N-1 || j == N-1) ? GameModel::Wall : GameModel::Floor;
+        }
+    }
+
+    GameRandom random(seed);
+    int placedWallNum = 0;
+    while (placedWallNum < _params.wallnum){
+        int xPos = random.bounded(N-2) + 1;
+        int yPos = random.bounded(N-2) + 1;
+        if( !(xPos == 1 && yPos == 1) && t[xPos*N + yPos] == GameModel::Floor && !(xPos < 6 && yPos < 6)){
+            t[xPos*N + yPos] = GameModel::Wall;
+            placedWallNum++;
+        }
+    }
+
+    pX[e] = 1;
+    pY[e] = 1;
+    died[e] = 0;
+    eCount[e] = 0;
+    while (eCount[e] < _params.enemynum){
+        int x = random.bounded(N-2-(N/4)) + 1 + (N/4);
+        int y = random.bounded(N-2-(N/4)) + 1 + (N/4);
+        if (enemyCanStep(e, x, y)){
+            int k = e * maxEnemies + eCount[e];
+            eX[k] = x;
+            eY[k] = y;
+            eFacing[k] = startFacing[random.bounded(4)];
+            eCount[e]++;
+        }
+    }
+
+    rng[e] = random.state;
+    waiting[e] = 0;
+    delay[e] = 4;
+    time[e] = 0;
+    tick[e] = 0;
+}
+
+
+//Puts the state of a model's game into slot 'e', e.g. to play it on from there in many ways (see WinEstimator).
+//The model's clock doesn't carry over: the next second passes after 'enemyspd' steps. The enemies over the
+//environment's enemy count are left out, and so are the charges of designed levels (the games have no chain
+//reactions); 'seed' starts the random turns of the enemies.
+bool BatchEnvironment::loadState(int e, const GameModel::State &s, quint32 seed){
+    if (s.tiles.size() != cells) return false;
+    quint8* t = tileData + e * cells;
+    for (int i = 0; i < cells; i++) t[i] = s.tiles[i];
+
+    pX[e] = s.player.x;
+    pY[e] = s.player.y;
+    died[e] = s.playerDied;
+    eCount[e] = qMin(s.enemies.size(), maxEnemies);
+    for (int k = 0; k < eCount[e]; k++){
+        eX[e * maxEnemies + k] = s.enemies[k].x;
+        eY[e * maxEnemies + k] = s.enemies[k].y;
+        eFacing[e * maxEnemies + k] = s.enemies[k].facing;
+    }
+
+    rng[e] = GameRandom(seed).state;
+    waiting[e] = s.waitingForExplosion;
+    delay[e] = s.explosionDelay;
+    tX[e] = s.target.x;
+    tY[e] = s.target.y;
+    time[e] = s.gameTime;
+    tick[e] = 0;
+    return true;
+}
+
+
+//GameModel::checkEnemyNewPos: false if (x,y) is a wall or there is an enemy on it; kills the player standing on it
+bool BatchEnvironment::enemyCanStep(int e, int x, int y){
+    if (x == pX[e] && y == pY[e]) died[e] = 1;
+
+    quint8 tile = tileData[e * cells + x * _size + y];
+    if (tile == GameModel::Wall || tile == GameModel::WallUnderExplosion) return false;
+    const qint16* ex = eX + e * maxEnemies;
+    const qint16* ey = eY + e * maxEnemies;
+    for (int k = 0; k < eCount[e]; k++){
+        if (ex[k] == x && ey[k] == y) return false;
+    }
+    return true;
+}
+
+
+//GameModel::playerMoved and checkPlayerNewPos
+void BatchEnvironment::playerMove(int e, int dir){
+    int x = pX[e] + stepX[dir];
+    int y = pY[e] + stepY[dir];
+    quint8 tile = tileData[e * cells + x * _size + y];
+    if (tile == GameModel::Wall || tile == GameModel::WallUnderExplosion) return;
+
+    pX[e] = x;
+    pY[e] = y;
+    if (tile == GameModel::FloorUnderExplosion) {
+        died[e] = 1;
+        return;
+    }
+    const qint16* ex = eX + e * maxEnemies;
+    const qint16* ey = eY + e * maxEnemies;
+    for (int k = 0; k < eCount[e]; k++){
+        if (ex[k] == x && ey[k] == y) died[e] = 1;
+    }
+}
+
+
+//GameModel::moveEnemies. Like there, an enemy walking into an explosion is removed,
+//and the enemy after it in the list doesn't move in that step.
+void BatchEnvironment::moveEnemies(int e, TileHeatmap* heat){
+    qint16* ex = eX + e * maxEnemies;
+    qint16* ey = eY + e * maxEnemies;
+    quint8* ef = eFacing + e * maxEnemies;
+    const quint8* t = tileData + e * cells;
+    GameRandom random;
+    random.state = rng[e];
+
+    for (int k = 0; k < eCount[e]; k++){
+        int dir = ef[k];
+        int x = ex[k] + stepX[dir];
+        int y = ey[k] + stepY[dir];
+        if (t[x * _size + y] == GameModel::FloorUnderExplosion){
+            if (heat) heat->enemyKilled(x, y);
+            for (int m = k; m < eCount[e] - 1; m++){
+                ex[m] = ex[m+1];
+                ey[m] = ey[m+1];
+                ef[m] = ef[m+1];
+            }
+            eCount[e]--;
+        } else if (enemyCanStep(e, x, y)){
+            ex[k] = x;
+            ey[k] = y;
+        } else {
+            //the open directions are read from the neighbours: unlike the model, the games don't keep a mask per tile
+            const quint8* row = t + ex[k] * _size;
+            ef[k] = quint8(turnToOpen(openDirections(row - _size, row, row + _size, ey[k]), dir, random));
+        }
+    }
+
+    rng[e] = random.state;
+}
+
+
+//GameModel::timerTimeout and bombTarget: the countdown of the airstrike, the explosion, and its end
+template <bool DestroyWalls>
+void BatchEnvironment::secondPassed(int e, TileHeatmap* heat){
+    typedef BlastKernel<DestroyWalls> K;
+    FlatTable<quint8> table = {tileData + e * cells, _size};
+
+    if (waiting[e]){
+        if (delay[e] > 1) delay[e]--;
+        else if (delay[e] == 1){
+            K::apply(table, _size, stencil, tX[e], tY[e]);
+            if (heat) heat->blastHit(tX[e], tY[e], stencil);
+            if (stencil.covers(pX[e] - tX[e], pY[e] - tY[e])) died[e] = 1;
+
+            qint16* ex = eX + e * maxEnemies;
+            qint16* ey = eY + e * maxEnemies;
+            quint8* ef = eFacing + e * maxEnemies;
+            int kept = 0;
+            for (int k = 0; k < eCount[e]; k++){
+                if ( !stencil.covers(ex[k] - tX[e], ey[k] - tY[e]) ){
+                    ex[kept] = ex[k];
+                    ey[kept] = ey[k];
+                    ef[kept] = ef[k];
+                    kept++;
+                } else if (heat) {
+                    heat->enemyKilled(ex[k], ey[k]);
+                }
+            }
+            eCount[e] = kept;
+            delay[e]--;
+        } else {
+            K::clear(table, _size, stencil, tX[e], tY[e]);
+            waiting[e] = 0;
+            delay[e] = 4;
+        }
+    }
+    time[e]++;
+}
+
+
+//One step of the games in [begin, end). A finished game is restarted right away,
+//with the next number of its own random sequence as the seed.
+//With 'heat', the deaths, kills and blasts are counted into it (the player dies where they stand, whatever killed them).
+template <bool DestroyWalls>
+void BatchEnvironment::stepRange(const quint8* actions, int begin, int end, TileHeatmap* heat){
+    for (int e = begin; e < end; e++){
+        int enemiesBefore = eCount[e];
+        bool over = false;
+
+        switch (actions[e]){
+            case MoveUp: playerMove(e, GameModel::Up); break;
+            case MoveRight: playerMove(e, GameModel::Right); break;
+            case MoveDown: playerMove(e, GameModel::Down); break;
+            case MoveLeft: playerMove(e, GameModel::Left); break;
+            case CallAirstrike:
+                if (!waiting[e]){
+                    tX[e] = pX[e];
+                    tY[e] = pY[e];
+                    tileData[e * cells + tX[e] * _size + tY[e]] = GameModel::TargetFloor;
+                    waiting[e] = 1;
+                }
+                break;
+            default: break;
+        }
+        over = died[e];
+
+        if (!over){
+            moveEnemies(e, heat);
+            over = died[e] || eCount[e] == 0;
+        }
+        if (!over && ++tick[e] == _params.enemyspd){
+            tick[e] = 0;
+            secondPassed<DestroyWalls>(e, heat);
+            over = died[e];
+        }
+
+        if (heat && died[e]) heat->playerDied(pX[e], pY[e]);
+        reward[e] = float(enemiesBefore - eCount[e]) - (died[e] ? 1.0f : 0.0f);
+        done[e] = over;
+        won[e] = over && !died[e];
+        if (over) {
+            GameRandom next;
+            next.state = rng[e];
+            resetGame(e, quint32(next.bounded(0x7FFFFFFF)));
+        }
+    }
+}
+
+
+
+//-----DISPATCH-----
+
+//The same choice as selectBlastFunctions: the whole step is specialized, not just the blast.
+BatchEnvironment::StepFunction BatchEnvironment::selectStepFunction(bool destroywalls){
+    return destroywalls ? &BatchEnvironment::stepRange<true> : &BatchEnvironment::stepRange<false>;
+}
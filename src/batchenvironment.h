@@ -0,0 +1,142 @@
+#ifndef BATCHENVIRONMENT_H
+#define BATCHENVIRONMENT_H
+
+#include <QVector>
+#include <QThreadPool>
+#include <QRunnable>
+#include "gamemodel.h"
+#include "tileheatmap.h"
+
+//Runs many games at once for training agents, without QObjects, timers or an event loop.
+//The state of all games is stored as a structure of arrays (one array per property, indexed by game),
+//and step() advances every game by one tick with one action each. Finished games start over on their own.
+//
+//The rules are the same as GameModel's; one step is:
+//  1. the action of the player (a move, calling an airstrike, or nothing),
+//  2. one step of the enemies (GameModel::moveEnemies),
+//  3. every 'enemyspd'-th step, one second of game time (GameModel::timerTimeout: the airstrike countdown).
+//The same seed produces the same board as GameModel::reset.
+class BatchEnvironment
+{
+public:
+    enum Action { Stay, MoveUp, MoveRight, MoveDown, MoveLeft, CallAirstrike };
+
+    //the results of a step, valid until the next step() or reset()
+    struct StepResult{
+        const float* rewards;  //+1 for each enemy killed in this step, -1 if the player died
+        const quint8* dones;   //1 if the game ended in this step (it has already been restarted since)
+        const quint8* wins;    //1 if the game ended in this step with every enemy killed
+        const quint8* tiles;   //the boards of all games, 'size*size' GameModel::TileType values each (row after row)
+    };
+
+    //'threads' == 0 uses every core; the blast is GameModel's default unless 'stencil' says otherwise
+    BatchEnvironment(int count, const GameModel::Params &params, int threads = 0, const BlastStencil &stencil = BlastStencil());
+    ~BatchEnvironment();
+
+    //starts a new game in every environment; 'seeds' has one seed for each
+    void reset(const quint32* seeds);
+    //advances every game by one step; 'actions' has one Action for each
+    StepResult step(const quint8* actions);
+    //starts a new game in one environment (e.g. one that went on for too long)
+    void restartGame(int env, quint32 seed) {resetGame(env, seed);}
+    //goes on with a game of a model instead (see GameModel::saveState); false if the board sizes differ
+    bool loadState(int env, const GameModel::State &s, quint32 seed);
+
+    int count() const {return n;}
+    int size() const {return _size;}
+    const GameModel::Params& params() const {return _params;}
+    qint64 totalSteps() const {return steps;}
+    int finishedGames() const {return finished;}
+
+    //turns the statistics of the games on or off (off by default); turning them on zeroes them.
+    //Each worker counts into a heatmap of its own, so counting needs no synchronization.
+    void setHeatmapsEnabled(bool on);
+    //adds the statistics of every worker since they were turned on to 'out' (which is resized to the board if needed)
+    void collectHeatmap(TileHeatmap &out) const;
+
+    //the state of one game (for observations, see also ObservationEncoder)
+    const quint8* tiles(int env) const {return tileData + env * cells;}
+    int playerX(int env) const {return pX[env];}
+    int playerY(int env) const {return pY[env];}
+    int enemyCount(int env) const {return eCount[env];}
+    int enemyX(int env, int k) const {return eX[env * maxEnemies + k];}
+    int enemyY(int env, int k) const {return eY[env * maxEnemies + k];}
+    int enemyFacing(int env, int k) const {return eFacing[env * maxEnemies + k];}
+    bool airstrikePending(int env) const {return waiting[env];}
+    int targetX(int env) const {return tX[env];}
+    int targetY(int env) const {return tY[env];}
+    int countdown(int env) const {return delay[env];}
+    const BlastStencil& blastStencil() const {return stencil;}
+    int gameTime(int env) const {return time[env];}
+    quint32 randomState(int env) const {return rng[env];}
+
+private:
+    int n;
+    int _size;
+    int cells;
+    int maxEnemies;
+    BlastStencil stencil; //the blast of the airstrikes
+    GameModel::Params _params;
+    qint64 steps;
+    int finished;
+
+    //one element (or one block of 'cells' / 'maxEnemies' elements) per game
+    QVector<quint8> tileStore;
+    QVector<qint16> pXStore, pYStore;
+    QVector<qint16> eXStore, eYStore;
+    QVector<quint8> eFacingStore;
+    QVector<int> eCountStore;
+    QVector<quint8> waitingStore;
+    QVector<qint8> delayStore;
+    QVector<qint16> tXStore, tYStore;
+    QVector<int> timeStore;
+    QVector<int> tickStore;
+    QVector<quint32> rngStore;
+    QVector<quint8> diedStore;
+    QVector<float> rewardStore;
+    QVector<quint8> doneStore;
+    QVector<quint8> winStore;
+
+    //raw pointers into the arrays above (they are never reallocated after the constructor)
+    quint8* tileData;
+    qint16 *pX, *pY, *eX, *eY;
+    quint8* eFacing;
+    int* eCount;
+    quint8* waiting;
+    qint8* delay;
+    qint16 *tX, *tY;
+    int *time, *tick;
+    quint32* rng;
+    quint8* died;
+    float* reward;
+    quint8* done;
+    quint8* won;
+
+    //the step of a range of games, compiled for the rules of this environment (see blastkernel.h)
+    typedef void (BatchEnvironment::*StepFunction)(const quint8* actions, int begin, int end, TileHeatmap* heat);
+    StepFunction stepFunction;
+    template <bool DestroyWalls> void stepRange(const quint8* actions, int begin, int end, TileHeatmap* heat);
+    static StepFunction selectStepFunction(bool destroywalls);
+
+    void resetGame(int e, quint32 seed);
+    void playerMove(int e, int dir);
+    void moveEnemies(int e, TileHeatmap* heat);
+    bool enemyCanStep(int e, int x, int y);
+    template <bool DestroyWalls> void secondPassed(int e, TileHeatmap* heat);
+
+    //the games are stepped in chunks, one per worker
+    class Chunk : public QRunnable
+    {
+    public:
+        BatchEnvironment* env;
+        const quint8* actions;
+        int begin;
+        int end;
+        TileHeatmap* heatmap; //the statistics counted by this chunk, or 0
+        void run() {(env->*(env->stepFunction))(actions, begin, end, heatmap);}
+    };
+    QThreadPool pool;
+    QVector<Chunk*> chunks;
+};
+
+#endif // BATCHENVIRONMENT_H
@@ -0,0 +1,152 @@
+#ifndef BLASTKERNEL_H
+#define BLASTKERNEL_H
+
+#include "gamemodel.h"
+#include "blaststencil.h"
+
+//The blast of an airstrike, compiled separately for each set of rules ('DestroyWalls' is the rule of the game).
+//The shape comes from a BlastStencil: each of its row spans is clipped to the board once, then stamped in one go,
+//so there are no per-tile bounds checks whatever the shape and radius. The tiles are stamped through lookup tables
+//instead of comparisons, so the stamping itself doesn't branch.
+//
+//A table is anything that rowData() can get a row pointer from (see below): the nested QVectors of GameModel,
+//or a flat grid with a row stride.
+
+inline GameModel::TileType* rowData(QVector< QVector<GameModel::TileType> > &table, int i) {return table[i].data();}
+
+//a board stored row after row in one block of memory
+template <typename Cell>
+struct FlatTable{
+    Cell* data;
+    int stride;
+};
+
+template <typename Cell>
+inline Cell* rowData(FlatTable<Cell> &table, int i) {return table.data + i * table.stride;}
+
+
+//what each tile type becomes when a blast reaches it, if walls can't be destroyed...
+static const GameModel::TileType blastOverTile[5] = {
+    GameModel::FloorUnderExplosion, //Floor
+    GameModel::WallUnderExplosion,  //Wall
+    GameModel::WallUnderExplosion,  //FloorUnderExplosion
+    GameModel::WallUnderExplosion,  //WallUnderExplosion
+    GameModel::FloorUnderExplosion  //TargetFloor
+};
+
+//...and when the blast is over
+static const GameModel::TileType tileAfterBlast[5] = {
+    GameModel::Floor,               //Floor
+    GameModel::Wall,                //Wall
+    GameModel::Floor,               //FloorUnderExplosion
+    GameModel::Wall,                //WallUnderExplosion
+    GameModel::TargetFloor          //TargetFloor
+};
+
+
+template <bool DestroyWalls>
+struct BlastKernel
+{
+    //stamps the explosion around (x,y) on the inner tiles of the table (the outer walls are never hit)
+    template <typename Table>
+    static void apply(Table &table, int size, const BlastStencil &stencil, int x, int y){
+        const BlastStencil::Span* s = stencil.spans().constData();
+        for (int k = 0; k < stencil.spans().size(); k++){
+            int i = x + s[k].dx;
+            if (i < 1 || i > size - 2) continue;
+            int left = qMax(y + s[k].left, 1), right = qMin(y + s[k].right, size - 2);
+            if (left <= right) stampRow(rowData(table, i) + left, right - left + 1);
+        }
+    }
+
+    //removes the explosion around (x,y)
+    template <typename Table>
+    static void clear(Table &table, int size, const BlastStencil &stencil, int x, int y){
+        const BlastStencil::Span* s = stencil.spans().constData();
+        for (int k = 0; k < stencil.spans().size(); k++){
+            int i = x + s[k].dx;
+            if (i < 1 || i > size - 2) continue;
+            int left = qMax(y + s[k].left, 1), right = qMin(y + s[k].right, size - 2);
+            if (left <= right) clearRow(rowData(table, i) + left, right - left + 1);
+        }
+    }
+
+    //One blast of a chain reaction (see GameModel::detonate): stamps the explosion around (x,y) like apply, but only
+    //on the tiles that no earlier blast of the same reaction has stamped. 'stamped' has a cell per tile (row after row),
+    //and the tiles of this blast get 'mark' in it. So every tile is stamped once however many blasts overlap on it,
+    //and the killing is left to a single pass over the marks.
+    template <typename Table>
+    static void applyOnce(Table &table, int size, const BlastStencil &stencil, int x, int y, quint32* stamped, quint32 mark){
+        changeOnce<true>(table, size, stencil, x, y, stamped, mark);
+    }
+
+    //removes the explosion of one blast of a chain reaction, skipping the tiles marked with 'mark' (see applyOnce)
+    template <typename Table>
+    static void clearOnce(Table &table, int size, const BlastStencil &stencil, int x, int y, quint32* cleared, quint32 mark){
+        changeOnce<false>(table, size, stencil, x, y, cleared, mark);
+    }
+
+private:
+    template <typename Cell>
+    static void stampRow(Cell* row, int length){
+        for (int j = 0; j < length; j++){
+            if (DestroyWalls) row[j] = Cell(GameModel::FloorUnderExplosion);
+            else row[j] = Cell(blastOverTile[row[j]]);
+        }
+    }
+
+    template <typename Cell>
+    static void clearRow(Cell* row, int length){
+        for (int j = 0; j < length; j++) row[j] = Cell(tileAfterBlast[row[j]]);
+    }
+
+    //Stamps (or clears) the tiles of the blast around (x,y) that aren't marked with 'mark' yet, and marks them.
+    //Each run of unmarked tiles of a span is marked, then stamped in one go; a lone blast has one run per span.
+    template <bool Stamp, typename Table>
+    static void changeOnce(Table &table, int n, const BlastStencil &stencil, int x, int y, quint32* marks, quint32 mark){
+        const BlastStencil::Span* s = stencil.spans().constData();
+        for (int k = 0; k < stencil.spans().size(); k++){
+            int i = x + s[k].dx;
+            if (i < 1 || i > n - 2) continue;
+            int left = qMax(y + s[k].left, 1), right = qMin(y + s[k].right, n - 2);
+            quint32* m = marks + i * n;
+            auto row = rowData(table, i);
+            int j = left;
+            while (j <= right){
+                while (j <= right && m[j] == mark) j++;
+                int start = j;
+                while (j <= right && m[j] != mark) m[j++] = mark;
+                if (j == start) continue;
+                if (Stamp) stampRow(row + start, j - start);
+                else clearRow(row + start, j - start);
+            }
+        }
+    }
+};
+
+
+//The runtime side: the kernels chosen for the current rules.
+struct BlastFunctions
+{
+    void (*apply)(QVector< QVector<GameModel::TileType> > &table, int size, const BlastStencil &stencil, int x, int y);
+    void (*clear)(QVector< QVector<GameModel::TileType> > &table, int size, const BlastStencil &stencil, int x, int y);
+    void (*applyOnce)(QVector< QVector<GameModel::TileType> > &table, int size, const BlastStencil &stencil, int x, int y, quint32* stamped, quint32 mark);
+    void (*clearOnce)(QVector< QVector<GameModel::TileType> > &table, int size, const BlastStencil &stencil, int x, int y, quint32* cleared, quint32 mark);
+};
+
+template <bool DestroyWalls>
+const BlastFunctions* blastFunctions(){
+    typedef BlastKernel<DestroyWalls> K;
+    static const BlastFunctions f = { &K::template apply< QVector< QVector<GameModel::TileType> > >,
+                                      &K::template clear< QVector< QVector<GameModel::TileType> > >,
+                                      &K::template applyOnce< QVector< QVector<GameModel::TileType> > >,
+                                      &K::template clearOnce< QVector< QVector<GameModel::TileType> > > };
+    return &f;
+}
+
+//Picks the kernels for the rule of the walls; the board size is a runtime parameter of every kernel.
+inline const BlastFunctions* selectBlastFunctions(bool destroywalls){
+    return destroywalls ? blastFunctions<true>() : blastFunctions<false>();
+}
+
+#endif // BLASTKERNEL_H
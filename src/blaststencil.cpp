@@ -0,0 +1,99 @@
+#include "blaststencil.h"
+#include <QtGlobal>
+
+BlastStencil::BlastStencil()
+{
+    *this = BlastStencil(Square, 3);
+}
+
+
+//The built-in shapes are drawn, then turned into spans like the custom ones.
+BlastStencil::BlastStencil(Shape shape, int radius):
+    _shape(shape == Custom ? Square : shape), _radius(qMax(1, radius))
+{
+    int r = _radius;
+    QList<QByteArray> drawn;
+    for (int dx = -r; dx <= r; dx++){
+        QByteArray row(2*r + 1, '.');
+        for (int dy = -r; dy <= r; dy++){
+            bool covered = _shape == Square ||
+                           (_shape == Cross && (dx == 0 || dy == 0)) ||
+                           (_shape == Diamond && qAbs(dx) + qAbs(dy) <= r);
+            if (covered) row[dy + r] = 'X';
+        }
+        drawn.append(row);
+    }
+    build(drawn);
+}
+
+
+bool BlastStencil::custom(const QList<QByteArray> &rows, BlastStencil &out){
+    int n = rows.size();
+    if (n % 2 == 0) return false;
+    foreach (const QByteArray &row, rows){
+        if (row.size() != n) return false;
+    }
+    out._shape = Custom;
+    out._radius = n / 2;
+    out.build(rows);
+    return true;
+}
+
+
+void BlastStencil::build(const QList<QByteArray> &rows){
+    int r = _radius;
+    _spans.clear();
+    rowStart.resize(2*r + 2);
+    for (int i = 0; i < rows.size(); i++){
+        rowStart[i] = _spans.size();
+        const QByteArray &row = rows[i];
+        for (int j = 0; j < row.size(); j++){
+            if (row[j] != 'X') continue;
+            Span s;
+            s.dx = i - r;
+            s.left = j - r;
+            while (j + 1 < row.size() && row[j + 1] == 'X') j++;
+            s.right = j - r;
+            _spans.append(s);
+        }
+    }
+    rowStart[2*r + 1] = _spans.size();
+}
+
+
+bool BlastStencil::covers(int dx, int dy) const{
+    if (dx < -_radius || dx > _radius) return false;
+    for (int k = rowStart[dx + _radius]; k < rowStart[dx + _radius + 1]; k++){
+        if (_spans[k].left <= dy && dy <= _spans[k].right) return true;
+    }
+    return false;
+}
+
+
+int BlastStencil::tileCount() const{
+    int count = 0;
+    foreach (const Span &s, _spans) count += s.right - s.left + 1;
+    return count;
+}
+
+
+QList<QByteArray> BlastStencil::rows() const{
+    int r = _radius;
+    QList<QByteArray> drawn;
+    for (int i = 0; i < 2*r + 1; i++) drawn.append(QByteArray(2*r + 1, '.'));
+    foreach (const Span &s, _spans){
+        for (int dy = s.left; dy <= s.right; dy++) drawn[s.dx + r][dy + r] = 'X';
+    }
+    return drawn;
+}
+
+
+//Stencils covering the same tiles are equal, whichever way they were made.
+bool BlastStencil::operator==(const BlastStencil &other) const{
+    if (_radius != other._radius || _spans.size() != other._spans.size()) return false;
+    for (int k = 0; k < _spans.size(); k++){
+        const Span &a = _spans[k], &b = other._spans[k];
+        if (a.dx != b.dx || a.left != b.left || a.right != b.right) return false;
+    }
+    return true;
+}
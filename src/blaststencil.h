@@ -0,0 +1,52 @@
+#ifndef BLASTSTENCIL_H
+#define BLASTSTENCIL_H
+
+#include <QVector>
+#include <QList>
+#include <QByteArray>
+
+//The shape of a blast around its center: the tiles it stamps, and the ones where it kills (they are the same).
+//A stencil is worked out once, into spans of columns row by row (one per row for the built-in shapes, more for a
+//custom shape with gaps), so a blast of any shape and radius costs one span operation per row wherever it is used:
+//stamping and clearing (see BlastKernel), the kill tests, setting off charges and counting the hits of a heatmap.
+class BlastStencil
+{
+public:
+    enum Shape { Square, Cross, Diamond, Custom };
+
+    //the tiles (x + dx, y + left) .. (x + dx, y + right) of a blast centered on (x,y)
+    struct Span{
+        int dx;
+        int left;
+        int right;
+    };
+
+    //the airstrike of the game: a 7x7 square
+    BlastStencil();
+    //the radius is the furthest a blast goes from its center, along the rows and the columns (at least 1)
+    BlastStencil(Shape shape, int radius);
+    //A custom shape, drawn with 'X' for the tiles it covers (anything else doesn't) in rows of the same odd length,
+    //as many as their length; the middle tile is the center. Returns false (and leaves 'out' alone) if they aren't.
+    static bool custom(const QList<QByteArray> &rows, BlastStencil &out);
+
+    Shape shape() const {return _shape;}
+    int radius() const {return _radius;}
+    const QVector<Span>& spans() const {return _spans;}
+    bool covers(int dx, int dy) const;
+    int tileCount() const;
+    //the shape drawn like custom() takes it
+    QList<QByteArray> rows() const;
+
+    bool operator==(const BlastStencil &other) const;
+    bool operator!=(const BlastStencil &other) const {return !(*this == other);}
+
+private:
+    Shape _shape;
+    int _radius;
+    QVector<Span> _spans;  //row after row, left to right
+    QVector<int> rowStart; //the first span of each row (by dx + radius); the last one is the end of the spans
+
+    void build(const QList<QByteArray> &rows);
+};
+
+#endif // BLASTSTENCIL_H
@@ -0,0 +1,87 @@
+#include "boardpregenerator.h"
+#include <QDateTime>
+
+BoardPregenerator::BoardPregenerator():
+    running(false), requested(false), wantedSeed(0), ready(false), generated(0), seeds(0)
+{
+    wanted.size = 0;
+    wanted.wallnum = 0;
+    wanted.enemynum = 0;
+    wanted.enemyspd = 1;
+    wanted.destroywalls = false;
+    job.owner = this;
+    job.setAutoDelete(false);
+    pool.setMaxThreadCount(1);
+}
+
+//Waits for the board being made; nothing else is started.
+BoardPregenerator::~BoardPregenerator(){
+    mutex.lock();
+    requested = false;
+    mutex.unlock();
+    pool.waitForDone();
+}
+
+
+void BoardPregenerator::prepare(const GameModel::Params &params){
+    QMutexLocker lock(&mutex);
+    if ((ready || requested) && sameBoard(params, wanted)) return;
+    wanted = params;
+    //the seeds are time based like those of GameModel, but two boards asked for in the same ms still differ
+    wantedSeed = quint32(QDateTime::currentMSecsSinceEpoch()) + 0x9E3779B9u * ++seeds;
+    ready = false;
+    requested = true;
+    if (!running){
+        running = true;
+        pool.start(&job);
+    }
+}
+
+
+bool BoardPregenerator::take(const GameModel::Params &params, GameModel::State &b, quint32 &seed){
+    QMutexLocker lock(&mutex);
+    if (!ready || !sameBoard(params, wanted)) return false;
+    b = board;
+    seed = wantedSeed;
+    ready = false;
+    return true;
+}
+
+
+int BoardPregenerator::generatedBoards(){
+    QMutexLocker lock(&mutex);
+    return generated;
+}
+
+
+bool BoardPregenerator::sameBoard(const GameModel::Params &a, const GameModel::Params &b){
+    return a.size == b.size && a.wallnum == b.wallnum && a.enemynum == b.enemynum;
+}
+
+
+//The body of the job: makes the boards asked for, until there is none left. A board that was asked for while
+//the previous one was being made replaces it, so after a few quick slider changes only the last one is kept.
+//The board is made by a model of the job's own, the same way as GameModel::reset would make it.
+void BoardPregenerator::generate(){
+    GameModel generator(10, 0, 0, 1, false);
+    GameModel::State made;
+    mutex.lock();
+    while (requested){
+        GameModel::Params params = wanted;
+        quint32 seed = wantedSeed;
+        mutex.unlock();
+
+        generator.reset(params, seed);
+        generator.saveState(made);
+
+        mutex.lock();
+        generated++;
+        if (sameBoard(params, wanted) && seed == wantedSeed){
+            board = made;
+            ready = true;
+            requested = false;
+        }
+    }
+    running = false;
+    mutex.unlock();
+}
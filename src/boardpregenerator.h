@@ -0,0 +1,55 @@
+#ifndef BOARDPREGENERATOR_H
+#define BOARDPREGENERATOR_H
+
+#include <QThreadPool>
+#include <QRunnable>
+#include <QMutex>
+#include "gamemodel.h"
+
+//Generates the board of the next game on a background thread, while the current game is running, so that
+//starting a game doesn't have to wait for the placement of the walls and the enemies (see GameModel::createWalls).
+//The View asks for a board with prepare() whenever the settings change, and picks it up with take() at the start
+//of the next game (see GameModel::reset with a prepared state), if it is made by then.
+//Only one board is kept: asking for another one throws the previous one away.
+class BoardPregenerator
+{
+public:
+    BoardPregenerator();
+    ~BoardPregenerator();
+
+    //starts making a board for these parameters with a new seed, unless there is one (or one is being made) already
+    void prepare(const GameModel::Params &params);
+    //takes the board made for 'params'; never blocks: returns false if the board is still being made (it is kept for
+    //the next call), or if the last board asked for was for other parameters
+    bool take(const GameModel::Params &params, GameModel::State &board, quint32 &seed);
+    //the boards made so far (including the ones thrown away)
+    int generatedBoards();
+
+    //the board only depends on these parameters (and the seed)
+    static bool sameBoard(const GameModel::Params &a, const GameModel::Params &b);
+
+private:
+    class Job : public QRunnable
+    {
+    public:
+        BoardPregenerator* owner;
+        void run() {owner->generate();}
+    };
+
+    QThreadPool pool;
+    Job job;
+    //the members below are guarded by 'mutex'
+    QMutex mutex;
+    bool running;              //the job is on the pool
+    bool requested;            //a board is asked for, and not made yet
+    GameModel::Params wanted;
+    quint32 wantedSeed;
+    bool ready;                //'board' is made for 'wanted' and 'wantedSeed'
+    GameModel::State board;
+    int generated;
+    quint32 seeds;
+
+    void generate();
+};
+
+#endif // BOARDPREGENERATOR_H
@@ -0,0 +1,98 @@
+#include "boardwidget.h"
+#include <QPainter>
+#include <QWheelEvent>
+
+static const QColor floorColor(249, 255, 175);
+static const QColor wallColor(139, 139, 139);
+static const QColor playerColor(0, 70, 197);
+static const QColor enemyColor(193, 0, 0);
+static const QColor gridColor(Qt::gray);
+
+
+BoardWidget::BoardWidget(QWidget *parent):
+    QWidget(parent), crosshair(":/crosshair.png"), explosion(":/explosion.png")
+{
+    shown.top = 0;
+    shown.bottom = -1;
+    shown.left = 0;
+    shown.right = -1;
+    player.x = -1;
+    player.y = -1;
+    player.facing = GameModel::Right;
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+}
+
+
+//Moves the camera to the player, and takes the visible part of the frame (the tiles and the enemies on them).
+//The frame itself isn't kept, so it may change or go away right after this call.
+void BoardWidget::showFrame(const QVector<QVector<GameModel::TileType> > &tiles, const QVector<quint8> &enemyMap, const GameModel::Position &p){
+    view.setBoardSize(tiles.size());
+    view.follow(p.x, p.y);
+    shown = view.visibleTiles();
+    player = p;
+
+    int columns = shown.right - shown.left + 1;
+    shownTiles.resize(shown.isEmpty() ? 0 : (shown.bottom - shown.top + 1) * columns);
+    quint8* d = shownTiles.data();
+    for (int i = shown.top; i <= shown.bottom; ++i){
+        const GameModel::TileType* row = tiles[i].constData() + shown.left;
+        for (int j = 0; j < columns; ++j) *d++ = quint8(row[j]);
+    }
+
+    findEnemies(enemyMap, tiles.size(), shown, shownEnemies);
+    update();
+}
+
+
+void BoardWidget::zoom(int steps){
+    view.zoom(steps);
+    emit cameraChanged();
+}
+
+
+void BoardWidget::zoomToFit(){
+    view.zoomToFit();
+    emit cameraChanged();
+}
+
+
+void BoardWidget::paintEvent(QPaintEvent*){
+    QPainter painter(this);
+    int ts = view.tileSize();
+    int columns = shown.right - shown.left + 1;
+    const quint8* d = shownTiles.constData();
+    painter.setPen(gridColor);
+    for (int i = shown.top; i <= shown.bottom; ++i){
+        for (int j = shown.left; j <= shown.right; ++j){
+            QPoint at = view.tilePosition(i, j);
+            QRect r(at.x(), at.y(), ts, ts);
+            GameModel::TileType t = GameModel::TileType(d[(i - shown.top) * columns + j - shown.left]);
+            QColor color = floorColor;
+            if (t == GameModel::Wall || t == GameModel::WallUnderExplosion) color = wallColor;
+            if (i == player.x && j == player.y) color = playerColor;
+            painter.fillRect(r, color);
+            if (t == GameModel::TargetFloor) painter.drawPixmap(r, crosshair);
+            else if (t == GameModel::FloorUnderExplosion || t == GameModel::WallUnderExplosion) painter.drawPixmap(r, explosion);
+            painter.drawRect(r);
+        }
+    }
+
+    painter.setBrush(enemyColor);
+    foreach (const GameModel::Position &enemy, shownEnemies){
+        QPoint at = view.tilePosition(enemy.x, enemy.y);
+        painter.drawRect(at.x(), at.y(), ts, ts);
+    }
+}
+
+
+void BoardWidget::resizeEvent(QResizeEvent*){
+    view.setViewport(width(), height());
+    emit cameraChanged();
+}
+
+
+//one step of zoom for each notch of the wheel
+void BoardWidget::wheelEvent(QWheelEvent* event){
+    int steps = event->angleDelta().y() / 120;
+    if (steps != 0) zoom(steps);
+}
@@ -0,0 +1,45 @@
+#ifndef BOARDWIDGET_H
+#define BOARDWIDGET_H
+
+#include <QWidget>
+#include <QPixmap>
+#include "gamemodel.h"
+#include "camera.h"
+
+//Paints the game table through a Camera that follows the player, with zoom (the mouse wheel, or zoom()).
+//Only the tiles in the viewport are looked at: when a frame is shown, they are copied out of the table, and the
+//enemies on them are found on the model's enemy map (see findEnemies), so the cost of a frame depends on the size
+//of the viewport, not of the board or the number of enemies.
+class BoardWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit BoardWidget(QWidget *parent = 0);
+
+    void showFrame(const QVector<QVector<GameModel::TileType> > &tiles, const QVector<quint8> &enemyMap, const GameModel::Position &p);
+    void zoom(int steps);
+    void zoomToFit();
+    const Camera& camera() const {return view;}
+
+signals:
+    //the visible part of the board changed: the frame has to be shown again
+    void cameraChanged();
+
+protected:
+    void paintEvent(QPaintEvent*);
+    void resizeEvent(QResizeEvent*);
+    void wheelEvent(QWheelEvent* event);
+
+private:
+    Camera view;
+    //the visible part of the last frame
+    Camera::TileRange shown;
+    QVector<quint8> shownTiles; //row after row of 'shown'
+    QVector<GameModel::Position> shownEnemies;
+    GameModel::Position player;
+    QPixmap crosshair;
+    QPixmap explosion;
+};
+
+#endif // BOARDWIDGET_H
@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
+QT       += core gui network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -14,10 +14,53 @@ TEMPLATE = app
 
 SOURCES += main.cpp\
         gameview.cpp \
-    gamemodel.cpp
+    gamemodel.cpp \
+    blaststencil.cpp \
+    simulationthread.cpp \
+    framescheduler.cpp \
+    inputqueue.cpp \
+    framecodec.cpp \
+    spectatorpublisher.cpp \
+    replay.cpp \
+    levelloader.cpp \
+    boardpregenerator.cpp \
+    tileheatmap.cpp \
+    camera.cpp \
+    boardwidget.cpp \
+    minimap.cpp \
+    minimapwidget.cpp \
+    framerasterizer.cpp \
+    frameexporter.cpp \
+    batchenvironment.cpp \
+    referencebot.cpp \
+    winestimator.cpp
 
 HEADERS  += gameview.h \
-    gamemodel.h
+    gamemodel.h \
+    simulationthread.h \
+    triplebuffer.h \
+    spscqueue.h \
+    framescheduler.h \
+    inputqueue.h \
+    gamerandom.h \
+    blastkernel.h \
+    blaststencil.h \
+    openmask.h \
+    framecodec.h \
+    spectatorpublisher.h \
+    replay.h \
+    levelloader.h \
+    boardpregenerator.h \
+    tileheatmap.h \
+    camera.h \
+    boardwidget.h \
+    minimap.h \
+    minimapwidget.h \
+    framerasterizer.h \
+    frameexporter.h \
+    batchenvironment.h \
+    referencebot.h \
+    winestimator.h
 
 RESOURCES += \
     images.qrc
@@ -0,0 +1,41 @@
+#-------------------------------------------------
+#
+# Headless tools for batch runs of the game
+#
+#-------------------------------------------------
+
+QT       += core
+QT       -= gui
+
+TARGET = bomberbench
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+
+SOURCES += \
+    bomberbench.cpp \
+    ../gamemodel.cpp \
+    ../blaststencil.cpp \
+    ../replay.cpp \
+    ../tileheatmap.cpp \
+    ../minimap.cpp \
+    ../inputqueue.cpp \
+    ../batchenvironment.cpp \
+    ../observationencoder.cpp
+HEADERS += \
+    ../gamemodel.h \
+    ../replay.h \
+    ../tileheatmap.h \
+    ../minimap.h \
+    ../inputqueue.h \
+    ../gamerandom.h \
+    ../blastkernel.h \
+    ../blaststencil.h \
+    ../openmask.h \
+    ../batchenvironment.h \
+    ../observationencoder.h
+INCLUDEPATH += ..
+
+CONFIG += C++11
@@ -0,0 +1,62 @@
+#include <QCoreApplication>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QFile>
+#include "batchenvironment.h"
+#include "observationencoder.h"
+
+//Measures the speed of the batch environment with random actions.
+//With a window (0: the whole board, -1: no observations), the observations of every game are encoded after each step.
+//With a heatmap file, the deaths, kills and blasts of the games are counted per tile and written into it (see TileHeatmap).
+//usage: bomberbench [games] [steps] [threads] [size] [enemies] [walls] [window] [heatmap file]
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QStringList args = a.arguments();
+    int games = args.size() > 1 ? args[1].toInt() : 4096;
+    int steps = args.size() > 2 ? args[2].toInt() : 1000;
+    int threads = args.size() > 3 ? args[3].toInt() : 0;
+    GameModel::Params params;
+    params.size = args.size() > 4 ? args[4].toInt() : 20;
+    params.enemynum = args.size() > 5 ? args[5].toInt() : 5;
+    params.wallnum = args.size() > 6 ? args[6].toInt() : 20;
+    int window = args.size() > 7 ? args[7].toInt() : -1;
+    QString heatmapFile = args.size() > 8 ? args[8] : QString();
+    params.enemyspd = 3;
+    params.destroywalls = true;
+
+    BatchEnvironment env(games, params, threads);
+    env.setHeatmapsEnabled(!heatmapFile.isEmpty());
+    QVector<quint8> actions(games);
+    GameRandom random(1);
+    ObservationEncoder encoder(params.size, qMax(0, window));
+    QVector<quint8> observations(window >= 0 ? games * encoder.observationSize() : 0);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int s = 0; s < steps; s++){
+        for (int e = 0; e < games; e++) actions[e] = quint8(random.bounded(6));
+        env.step(actions.constData());
+        if (window >= 0) encoder.encodeAll(env, observations.data());
+    }
+    qint64 ms = qMax(qint64(1), timer.elapsed());
+
+    QTextStream out(stdout);
+    out << env.totalSteps() << " steps in " << ms << " ms: "
+        << qint64(env.totalSteps() * 1000.0 / ms) << " steps/s, "
+        << env.finishedGames() << " games finished" << endl;
+
+    if (!heatmapFile.isEmpty()){
+        TileHeatmap heat;
+        env.collectHeatmap(heat);
+        QFile file(heatmapFile);
+        if (!file.open(QIODevice::WriteOnly) || !heat.writeBinary(file)){
+            out << "could not write " << heatmapFile << endl;
+            return 1;
+        }
+        out << heat.total(TileHeatmap::PlayerDeaths) << " deaths, " << heat.total(TileHeatmap::EnemyKills) << " kills, "
+            << heat.total(TileHeatmap::BlastHits) << " tiles hit by blasts" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,41 @@
+#-------------------------------------------------
+#
+# Plays random games on the model and the batch environment side by side, and reports where they differ
+#
+#-------------------------------------------------
+
+QT       += core
+QT       -= gui
+
+TARGET = bomberdiff
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+
+SOURCES += \
+    bomberdiff.cpp \
+    ../gamemodel.cpp \
+    ../blaststencil.cpp \
+    ../replay.cpp \
+    ../tileheatmap.cpp \
+    ../minimap.cpp \
+    ../inputqueue.cpp \
+    ../batchenvironment.cpp \
+    ../differentialtester.cpp
+HEADERS += \
+    ../gamemodel.h \
+    ../replay.h \
+    ../tileheatmap.h \
+    ../minimap.h \
+    ../inputqueue.h \
+    ../gamerandom.h \
+    ../blastkernel.h \
+    ../blaststencil.h \
+    ../openmask.h \
+    ../batchenvironment.h \
+    ../differentialtester.h
+INCLUDEPATH += ..
+
+CONFIG += C++11
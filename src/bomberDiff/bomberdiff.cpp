@@ -0,0 +1,48 @@
+#include <QCoreApplication>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include "differentialtester.h"
+
+//Plays random games on GameModel and BatchEnvironment in lockstep, and prints a minimal trace of each game
+//that plays differently on them (see DifferentialTester); the exit code is 1 if there was any.
+//usage: bomberdiff [games] [threads] [seed]
+//       bomberdiff replay "<trace>"      plays one trace, and tells where it differs
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QStringList args = a.arguments();
+    QTextStream out(stdout);
+
+    if (args.size() > 2 && args[1] == "replay"){
+        DifferentialTester::Trace trace;
+        if (!DifferentialTester::parseTrace(args[2].toLatin1(), trace)){
+            out << "not a trace: " << args[2] << endl;
+            return 2;
+        }
+        QString difference;
+        int step = DifferentialTester::replay(trace, &difference);
+        if (step < 0) out << "no difference in " << trace.actions.size() << " steps" << endl;
+        else out << "differs after step " << step << ": " << difference << endl;
+        return step < 0 ? 0 : 1;
+    }
+
+    DifferentialTester::Settings settings;
+    if (args.size() > 1) settings.games = args[1].toLongLong();
+    if (args.size() > 2) settings.threads = args[2].toInt();
+    quint32 seed = args.size() > 3 ? args[3].toUInt() : 1;
+
+    DifferentialTester tester(settings);
+    QElapsedTimer timer;
+    timer.start();
+    DifferentialTester::Report report = tester.run(seed);
+    qint64 ms = qMax(qint64(1), timer.elapsed());
+
+    foreach (const DifferentialTester::Divergence &d, report.divergences){
+        out << DifferentialTester::formatTrace(d.trace) << endl;
+        out << "  differs after step " << d.step << ": " << d.difference << endl;
+    }
+    out << report.games << " games, " << report.steps << " steps in " << ms << " ms, "
+        << report.divergences.size() << " divergences" << endl;
+    return report.divergences.isEmpty() ? 0 : 1;
+}
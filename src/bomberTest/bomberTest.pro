@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += testlib
+QT       += testlib network
 
 TARGET = bombertest
 CONFIG   += console
@@ -15,7 +15,53 @@ TEMPLATE = app
 
 SOURCES += \
     bombertest.cpp \
-    gamemodel.cpp
+    ../gamemodel.cpp \
+    ../blaststencil.cpp \
+    ../replay.cpp \
+    ../tileheatmap.cpp \
+    ../camera.cpp \
+    ../minimap.cpp \
+    ../framerasterizer.cpp \
+    ../frameexporter.cpp \
+    ../levelloader.cpp \
+    ../boardpregenerator.cpp \
+    ../inputqueue.cpp \
+    ../batchenvironment.cpp \
+    ../observationencoder.cpp \
+    ../referencebot.cpp \
+    ../difficultytuner.cpp \
+    ../winestimator.cpp \
+    ../differentialtester.cpp \
+    ../simulationthread.cpp \
+    ../spectatorpublisher.cpp \
+    ../framescheduler.cpp \
+    ../framecodec.cpp
 DEFINES += SRCDIR=\\\"$$PWD/\\\"
 HEADERS += \
-    gamemodel.h
+    ../gamemodel.h \
+    ../replay.h \
+    ../tileheatmap.h \
+    ../camera.h \
+    ../minimap.h \
+    ../framerasterizer.h \
+    ../frameexporter.h \
+    ../levelloader.h \
+    ../boardpregenerator.h \
+    ../triplebuffer.h \
+    ../spscqueue.h \
+    ../inputqueue.h \
+    ../gamerandom.h \
+    ../blastkernel.h \
+    ../blaststencil.h \
+    ../openmask.h \
+    ../batchenvironment.h \
+    ../observationencoder.h \
+    ../referencebot.h \
+    ../difficultytuner.h \
+    ../winestimator.h \
+    ../differentialtester.h \
+    ../simulationthread.h \
+    ../spectatorpublisher.h \
+    ../framescheduler.h \
+    ../framecodec.h
+INCLUDEPATH += ..
@@ -3,6 +3,59 @@
 #include <QList>
 #include <QDebug>
 #include "gamemodel.h"
+#include "triplebuffer.h"
+#include "spscqueue.h"
+#include "inputqueue.h"
+#include "blastkernel.h"
+#include "batchenvironment.h"
+#include "differentialtester.h"
+#include "observationencoder.h"
+#include "framecodec.h"
+#include "replay.h"
+#include "levelloader.h"
+#include "boardpregenerator.h"
+#include "tileheatmap.h"
+#include "camera.h"
+#include "minimap.h"
+#include "frameexporter.h"
+#include "difficultytuner.h"
+#include "winestimator.h"
+#include "framescheduler.h"
+#include "simulationthread.h"
+#include <QBuffer>
+#include <QTemporaryDir>
+
+
+//The heap allocations are counted while 'countAllocations' is set (see zeroAllocationTicks).
+//Qt's containers allocate with malloc, not with operator new, so malloc itself is wrapped; this needs glibc
+//(and no address sanitizer, which wraps malloc too).
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+#define COUNT_ALLOCATIONS
+#endif
+static bool countAllocations = false;
+static int allocations = 0;
+#ifdef COUNT_ALLOCATIONS
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* p, size_t size);
+
+void* malloc(size_t size){
+    if (countAllocations) allocations++;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size){
+    if (countAllocations) allocations++;
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void* p, size_t size){
+    if (countAllocations) allocations++;
+    return __libc_realloc(p, size);
+}
+}
+#endif
 
 class BomberTest : public QObject
 {
@@ -23,6 +76,39 @@ private slots:
     void dieToExplosion2();
     void killEnemy();
     void dieToEnemy();
+    void tripleBufferHandoff();
+    void spscQueueOrder();
+    void inputQueueMerging();
+    void queuedMovesPerTick();
+    void commandsAgeInTicks();
+    void resetIsReproducible();
+    void blastKernelsAgree();
+    void batchResetMatchesModel();
+    void batchStepAutoResets();
+    void observationEncoding();
+    void clockCatchesUp();
+    void rollbackResimulates();
+    void spectatorStreamDecodes();
+    void replaySeeksToAnyTick();
+    void replayFollowsRollbacks();
+    void levelLoadsBothForms();
+    void killEnemyOnFixedMap();
+    void zeroAllocationTicks();
+    void pregeneratedBoardMatchesReset();
+    void heatmapCountsGames();
+    void blockedEnemiesTurnToOpenSide();
+    void observersSeeTheFrame();
+    void cameraShowsOnlyTheViewport();
+    void enemyMapFollowsEnemies();
+    void minimapFollowsBlasts();
+    void exporterWritesFrames();
+    void tunerStopsEarly();
+    void estimatorWeighsMoves();
+    void estimatorReadsThreadedFrames();
+    void chargesChainReact();
+    void stencilsShapeTheBlast();
+    void modelAndBatchAgree();
+    void schedulerMergesUpdates();
 };
 
 
@@ -207,6 +293,1364 @@ void BomberTest::dieToExplosion2(){
     QVERIFY(_model4->getPlayerDied());
 }
 
+//the consumer always gets the newest published value, and only once
+void BomberTest::tripleBufferHandoff(){
+    TripleBuffer<int> buffer;
+    QVERIFY( !buffer.update() );
+
+    buffer.backBuffer() = 1;
+    buffer.publish();
+    buffer.backBuffer() = 2;
+    buffer.publish();
+    QVERIFY( buffer.update() );
+    QCOMPARE(buffer.frontBuffer(), 2);
+    QVERIFY( !buffer.update() );
+    QCOMPARE(buffer.frontBuffer(), 2);
+
+    buffer.backBuffer() = 3;
+    buffer.publish();
+    QVERIFY( buffer.update() );
+    QCOMPARE(buffer.frontBuffer(), 3);
+}
+
+//items come out in the order they were pushed, and a full queue refuses new ones
+void BomberTest::spscQueueOrder(){
+    SpscQueue<int, 4> queue;
+    int item;
+    QVERIFY( queue.isEmpty() );
+    QVERIFY( !queue.pop(item) );
+
+    QVERIFY( queue.push(1) );
+    QVERIFY( queue.push(2) );
+    QVERIFY( queue.push(3) );
+    QVERIFY( !queue.push(4) );
+
+    for (int i=1; i<=3; i++){
+        QVERIFY( queue.pop(item) );
+        QCOMPARE(item, i);
+    }
+    QVERIFY( queue.isEmpty() );
+
+    //wrapping around the end of the ring
+    for (int i=0; i<10; i++){
+        QVERIFY( queue.push(i) );
+        QVERIFY( queue.pop(item) );
+        QCOMPARE(item, i);
+    }
+}
+
+//auto-repeated moves and repeated airstrike calls are merged into the pending ones, stale commands are dropped
+void BomberTest::inputQueueMerging(){
+    InputQueue queue;
+    GameModel::Command move = {GameModel::Command::Move, GameModel::Right, false};
+    GameModel::Command repeat = {GameModel::Command::Move, GameModel::Right, true};
+    GameModel::Command strike = {GameModel::Command::Airstrike, GameModel::Up, false};
+    GameModel::Command c;
+
+    QVERIFY( queue.push(move, 0) );
+    QVERIFY( !queue.push(repeat, 0) );
+    QVERIFY( !queue.push(repeat, 0) );
+    QVERIFY( queue.push(strike, 1) );
+    QVERIFY( !queue.push(strike, 1) );
+    QVERIFY( queue.push(move, 1) );
+    QCOMPARE(queue.mergedCommands(), 3);
+
+    QVERIFY( queue.pop(c, 2, 2) );
+    QCOMPARE(c.type, GameModel::Command::Move);
+    QVERIFY( queue.pop(c, 2, 2) );
+    QCOMPARE(c.type, GameModel::Command::Airstrike);
+    //the last move waited too long
+    QVERIFY( !queue.pop(c, 4, 2) );
+    QCOMPARE(queue.droppedCommands(), 1);
+    QVERIFY( queue.isEmpty() );
+
+    //with no move pending, an auto-repeated one is accepted
+    QVERIFY( queue.push(repeat, 5) );
+}
+
+//queued commands take effect at the input ticks, one move per tick
+void BomberTest::queuedMovesPerTick(){
+    GameModel model(10,0,1,1,false);
+    GameModel::Command right = {GameModel::Command::Move, GameModel::Right, false};
+    GameModel::Command down = {GameModel::Command::Move, GameModel::Down, false};
+    GameModel::Command strike = {GameModel::Command::Airstrike, GameModel::Up, false};
+
+    model.queueCommand(right);
+    model.queueCommand(strike);
+    model.queueCommand(down);
+    QCOMPARE(model.getPlayer().y, 1);
+
+    model.advanceInput();
+    QCOMPARE(model.getPlayer().x, 1);
+    QCOMPARE(model.getPlayer().y, 2);
+    QCOMPARE(model.getTable()[1][2], GameModel::Floor);
+
+    //the airstrike is called before the next move, at the player's new position
+    model.advanceInput();
+    QCOMPARE(model.getTable()[1][2], GameModel::TargetFloor);
+    QCOMPARE(model.getPlayer().x, 2);
+    QCOMPARE(model.getPlayer().y, 2);
+    QCOMPARE(model.getInputTicks(), 2);
+}
+
+//commands may wait two input ticks, however long those take on the wall clock
+void BomberTest::commandsAgeInTicks(){
+    GameModel fast(10,0,1,1,false);
+    GameModel slow(10,0,1,1,false);
+    slow.setPlayerMoveRate(2);
+    slow.setTimeScale(0.25);
+    GameModel::Command right = {GameModel::Command::Move, GameModel::Right, false};
+    GameModel::Command down = {GameModel::Command::Move, GameModel::Down, false};
+    GameModel* models[2] = {&fast, &slow};
+    for (int m = 0; m < 2; m++){
+        GameModel &model = *models[m];
+        model.queueCommand(right);
+        model.queueCommand(down);
+        model.queueCommand(right);
+        //this one would be applied three ticks after it was given
+        model.queueCommand(down);
+        for (int t = 0; t < 4; t++) model.advanceInput();
+        QCOMPARE(model.getPlayer().x, 2);
+        QCOMPARE(model.getPlayer().y, 3);
+        QCOMPARE(model.getInputQueue().droppedCommands(), 1);
+    }
+}
+
+//a reset model starts a fresh game, and the same seed always gives the same board
+void BomberTest::resetIsReproducible(){
+    GameModel::Params params = {15,30,5,3,true};
+    GameModel model(10,0,1,1,false);
+    model.airstrikeCalled();
+    model.playerMoved(GameModel::Right);
+
+    model.reset(params, 42);
+    QCOMPARE(model.getSeed(), quint32(42));
+    QCOMPARE(model.getTable().size(), 15);
+    QCOMPARE(model.getPlayer().x, 1);
+    QCOMPARE(model.getPlayer().y, 1);
+    QCOMPARE(model.getEnemies().size(), 5);
+    QVERIFY( !model.getPlayerDied() );
+    QVERIFY( !model.gamePaused() );
+    QVector< QVector<GameModel::TileType> > table = model.getTable();
+    QVector<GameModel::Position> enemies = model.getEnemies();
+
+    int walls = 0;
+    for (int i = 1; i < 14; i++){
+        for (int j = 1; j < 14; j++){
+            if (table[i][j] == GameModel::Wall) walls++;
+            QVERIFY( table[i][j] != GameModel::TargetFloor );
+        }
+    }
+    QCOMPARE(walls, 30);
+
+    //a different game in between, then the same seed again
+    model.reset(params, 7);
+    model.reset(params, 42);
+    QVERIFY( model.getTable() == table );
+    QCOMPARE(model.getEnemies().size(), enemies.size());
+    for (int i = 0; i < enemies.size(); i++){
+        QCOMPARE(model.getEnemies()[i].x, enemies[i].x);
+        QCOMPARE(model.getEnemies()[i].y, enemies[i].y);
+        QCOMPARE(model.getEnemies()[i].facing, enemies[i].facing);
+    }
+}
+
+//the blast kernels stamp exactly what the original per-tile loop did, at every target position
+void BomberTest::blastKernelsAgree(){
+    const int sizes[3] = {10, 13, 20};
+    for (int s = 0; s < 3; s++){
+        int size = sizes[s];
+        for (int destroy = 0; destroy < 2; destroy++){
+            GameModel model(size, size, 1, 1, destroy);
+            const BlastFunctions* kernels = selectBlastFunctions(destroy);
+            BlastStencil stencil;
+
+            for (int x = 1; x < size-1; x++){
+                for (int y = 1; y < size-1; y++){
+                    //airstrikes are only called on floor
+                    if (model.getTable()[x][y] != GameModel::Floor) continue;
+                    QVector< QVector<GameModel::TileType> > expected = model.getTable();
+                    expected[x][y] = GameModel::TargetFloor;
+                    QVector< QVector<GameModel::TileType> > a = expected;
+                    QVector< QVector<GameModel::TileType> > initial = model.getTable();
+
+                    for (int i = x-3; i < x+4; i++){
+                        for (int j = y-3; j < y+4; j++){
+                            if (i > 0 && i < size-1 && j > 0 && j < size-1){
+                                if ( destroy || expected[i][j] == GameModel::Floor || expected[i][j] == GameModel::TargetFloor ) expected[i][j] = GameModel::FloorUnderExplosion;
+                                else expected[i][j] = GameModel::WallUnderExplosion;
+                            }
+                        }
+                    }
+                    kernels->apply(a, size, stencil, x, y);
+                    QVERIFY( a == expected );
+
+                    kernels->clear(a, size, stencil, x, y);
+                    if (!destroy) QVERIFY( a == initial );
+                    QCOMPARE(a[x][y], GameModel::Floor);
+
+                    //the kernels of a chain reaction (the ones the model uses): a lone blast is the same as above...
+                    QVector<quint32> marks(size * size, 0);
+                    QVector< QVector<GameModel::TileType> > c = initial;
+                    c[x][y] = GameModel::TargetFloor;
+                    kernels->applyOnce(c, size, stencil, x, y, marks.data(), 1);
+                    QVERIFY( c == expected );
+                    //...and a second one beside it only stamps the tiles the first one didn't
+                    if (y + 4 < size - 1){
+                        QVector< QVector<GameModel::TileType> > both = expected;
+                        for (int i = qMax(x-3, 1); i < qMin(x+4, size-1); i++){
+                            if ( destroy || initial[i][y+4] == GameModel::Floor ) both[i][y+4] = GameModel::FloorUnderExplosion;
+                            else both[i][y+4] = GameModel::WallUnderExplosion;
+                        }
+                        kernels->applyOnce(c, size, stencil, x, y+1, marks.data(), 1);
+                        QVERIFY( c == both );
+                        kernels->clearOnce(c, size, stencil, x, y+1, marks.data(), 2);
+                    }
+                    kernels->clearOnce(c, size, stencil, x, y, marks.data(), 2);
+                    if (!destroy) QVERIFY( c == initial );
+                    QCOMPARE(c[x][y], GameModel::Floor);
+                }
+            }
+        }
+    }
+}
+
+//a game of the batch environment starts on the same board as a GameModel with the same seed
+void BomberTest::batchResetMatchesModel(){
+    GameModel::Params params = {20,40,8,3,false};
+    quint32 seeds[4] = {1, 2, 99, 123456};
+    BatchEnvironment batch(4, params, 1);
+    batch.reset(seeds);
+    GameModel model(10,0,1,1,false);
+
+    for (int e = 0; e < 4; e++){
+        model.reset(params, seeds[e]);
+        QVector< QVector<GameModel::TileType> > table = model.getTable();
+        for (int i = 0; i < 20; i++){
+            for (int j = 0; j < 20; j++){
+                QCOMPARE(int(batch.tiles(e)[i*20 + j]), int(table[i][j]));
+            }
+        }
+        QCOMPARE(batch.enemyCount(e), model.getEnemies().size());
+        for (int k = 0; k < batch.enemyCount(e); k++){
+            QCOMPARE(batch.enemyX(e, k), model.getEnemies()[k].x);
+            QCOMPARE(batch.enemyY(e, k), model.getEnemies()[k].y);
+        }
+    }
+}
+
+//games end (by dying or winning) and start over on their own, without disturbing the others
+void BomberTest::batchStepAutoResets(){
+    GameModel::Params params = {10,5,2,2,true};
+    const int count = 16;
+    BatchEnvironment batch(count, params, 1);
+    QVector<quint8> actions(count);
+    GameRandom random(5);
+
+    int ended = 0;
+    for (int s = 0; s < 2000; s++){
+        for (int e = 0; e < count; e++) actions[e] = quint8(random.bounded(6));
+        BatchEnvironment::StepResult result = batch.step(actions.constData());
+        for (int e = 0; e < count; e++){
+            if (result.dones[e]){
+                ended++;
+                //the new game has already begun
+                QCOMPARE(batch.playerX(e), 1);
+                QCOMPARE(batch.playerY(e), 1);
+                QCOMPARE(batch.enemyCount(e), 2);
+                QCOMPARE(batch.gameTime(e), 0);
+            }
+            QVERIFY( result.rewards[e] >= -1 && result.rewards[e] <= 2 );
+        }
+    }
+    QVERIFY( ended > 0 );
+    QCOMPARE(batch.finishedGames(), ended);
+    QCOMPARE(batch.totalSteps(), qint64(2000 * count));
+}
+
+//the model and the batch environment are encoded the same way, and a window sees walls beyond the board
+void BomberTest::observationEncoding(){
+    GameModel::Params params = {15,20,4,3,false};
+    quint32 seed = 77;
+    BatchEnvironment batch(1, params, 1);
+    batch.reset(&seed);
+    GameModel model(10,0,1,1,false);
+    model.reset(params, seed);
+
+    ObservationEncoder full(15);
+    QCOMPARE(full.observationSize(), ObservationEncoder::PlaneCount * 15 * 15);
+    QVector<quint8> fromModel(full.observationSize(), 7);
+    QVector<quint8> fromBatch(full.observationSize(), 7);
+    QVERIFY( full.encode(model, fromModel.data()) );
+    QVERIFY( full.encode(batch, 0, fromBatch.data()) );
+    QVERIFY( fromModel == fromBatch );
+    //outer walls, the player in the corner, and every enemy on its tile
+    QCOMPARE(int(fromModel[ObservationEncoder::WallPlane * 225]), 1);
+    QCOMPARE(int(fromModel[ObservationEncoder::PlayerPlane * 225 + 1*15 + 1]), 1);
+    int enemies = 0;
+    for (int i = 0; i < 225; i++) enemies += fromModel[ObservationEncoder::EnemyPlane * 225 + i];
+    QCOMPARE(enemies, 4);
+
+    QVector<float> floats(full.observationSize());
+    QVERIFY( full.encode(model, floats.data()) );
+    for (int i = 0; i < floats.size(); i++) QCOMPARE(floats[i], float(fromModel[i]));
+
+    //a 5x5 window around the player at (1,1): the first row and column are off the board
+    ObservationEncoder window(15, 5);
+    QVector<quint8> cropped(window.observationSize());
+    QVERIFY( window.encode(model, cropped.data()) );
+    for (int j = 0; j < 5; j++) QCOMPARE(int(cropped[ObservationEncoder::WallPlane * 25 + j]), 1);
+    QCOMPARE(int(cropped[ObservationEncoder::PlayerPlane * 25 + 2*5 + 2]), 1);
+    QCOMPARE(int(cropped[ObservationEncoder::WallPlane * 25 + 2*5 + 2]), 0);
+
+    //a game of another board size is refused, and the buffer is left alone
+    ObservationEncoder small(9);
+    QVector<quint8> untouched(small.observationSize(), 7);
+    QVERIFY( !small.encode(model, untouched.data()) );
+    QVERIFY( !small.encode(batch, 0, untouched.data()) );
+    QVERIFY( !small.encodeAll(batch, untouched.data()) );
+    QCOMPARE(untouched, QVector<quint8>(small.observationSize(), 7));
+}
+
+//the ticks are scheduled by the game clock: a late timeout catches up on them, and small steps don't drift
+void BomberTest::clockCatchesUp(){
+    GameModel model(20,0,1,1,false);
+    model.setPlayerMoveRate(8);
+
+    //five seconds at once: every tick is run, but the View is notified only once
+    model.advanceClock(5000);
+    QCOMPARE(model.getGameTime(), 5);
+    QCOMPARE(model.getInputTicks(), 40);
+    QVERIFY( model.getCoalescedUpdates() > 0 );
+
+    //a thousand 1 ms steps add up to exactly one more second
+    for (int i = 0; i < 1000; i++) model.advanceClock(1);
+    QCOMPARE(model.getGameTime(), 6);
+    QCOMPARE(model.getInputTicks(), 48);
+
+    model.setTimeScale(1000);
+    QCOMPARE(model.getTimeScale(), 64.0);
+
+    //exactly as many ticks as a timeout may run (8 inputs, an enemy step and a second each second): they are all run,
+    //and the clock isn't moved on to the next tick as if some had been given up on
+    GameModel limit(20,0,1,1,false);
+    limit.setPlayerMoveRate(8);
+    limit.advanceClock(50000);
+    QCOMPARE(limit.getGameTime(), 50);
+    QCOMPARE(limit.getInputTicks(), 400);
+    limit.advanceClock(1);
+    QCOMPARE(limit.getInputTicks(), 400);
+    limit.advanceClock(124);
+    QCOMPARE(limit.getInputTicks(), 401);
+}
+
+//A loopback stand-in for a remote player: one model gets the inputs on time, the other predicts "no input",
+//then corrects the ticks when the inputs arrive late. Both have to end up in the same state.
+void BomberTest::rollbackResimulates(){
+    GameModel::Params params = {15,10,3,2,true};
+    GameModel onTime(10,0,1,1,false);
+    GameModel late(10,0,1,1,false);
+    onTime.reset(params, 42);
+    late.reset(params, 42);
+    late.setRollbackWindow(64);
+
+    GameModel::TickInput inputs[40];
+    for (int t = 0; t < 40; t++){
+        GameModel::TickInput in = {t == 12, qint8(t % 3 == 0 ? -1 : (t < 20 ? GameModel::Down : GameModel::Right))};
+        inputs[t] = in;
+    }
+
+    for (int t = 0; t < 40; t++){
+        if (inputs[t].airstrike){
+            GameModel::Command c = {GameModel::Command::Airstrike, GameModel::Up, false};
+            onTime.queueCommand(c);
+        }
+        if (inputs[t].move >= 0){
+            GameModel::Command c = {GameModel::Command::Move, GameModel::Direction(inputs[t].move), false};
+            onTime.queueCommand(c);
+        }
+        onTime.advanceClock(125);
+        late.advanceClock(125);
+    }
+    QCOMPARE(late.getInputTicks(), 40);
+    QCOMPARE(late.getPlayer().x, 1);
+    QVERIFY( onTime.getPlayer().x > 1 );
+
+    //the real inputs arrive late (once the corrected game ends, there are no more ticks to correct)
+    for (int t = 0; t < 40 && t < late.getInputTicks(); t++) QVERIFY( late.correctInput(t, inputs[t]) );
+    QVERIFY( late.getResimulatedTicks() > 0 );
+    QCOMPARE(late.getInputTicks(), onTime.getInputTicks());
+    QCOMPARE(late.getGameTime(), onTime.getGameTime());
+    QCOMPARE(late.getPlayer().x, onTime.getPlayer().x);
+    QCOMPARE(late.getPlayer().y, onTime.getPlayer().y);
+    QCOMPARE(late.getPlayerDied(), onTime.getPlayerDied());
+    QCOMPARE(late.getEnemies().size(), onTime.getEnemies().size());
+    for (int k = 0; k < late.getEnemies().size(); k++){
+        QCOMPARE(late.getEnemies()[k].x, onTime.getEnemies()[k].x);
+        QCOMPARE(late.getEnemies()[k].y, onTime.getEnemies()[k].y);
+    }
+    QVERIFY( late.getTable() == onTime.getTable() );
+    //and the clocks are where they were (with nothing due after the last corrected tick, none is run)
+    GameModel::State lateState, onTimeState;
+    late.saveState(lateState);
+    onTime.saveState(onTimeState);
+    QCOMPARE(lateState.gameClock, onTimeState.gameClock);
+    QCOMPARE(lateState.nextInput, onTimeState.nextInput);
+
+    //a tick that has left the history can't be rolled back to
+    late.setRollbackWindow(4);
+    QVERIFY( !late.rollbackTo(0) );
+}
+
+//a spectator following the deltas sees the same game, and one that missed a delta waits for a keyframe
+void BomberTest::spectatorStreamDecodes(){
+    GameModel::Params params = {20,30,6,3,true};
+    GameModel model(10,0,1,1,false);
+    model.reset(params, 9);
+    FrameEncoder encoder;
+    FrameDecoder follower, latecomer;
+    FrameStatus status = {0, 0, false, 0, false, false, false};
+
+    int deltaBytes = 0;
+    for (int t = 0; t < 60; t++){
+        if (t == 3) model.airstrikeCalled();
+        if (t % 4 == 0) model.playerMoved(t < 30 ? GameModel::Down : GameModel::Right);
+        model.advanceClock(125);
+        status.gameTime = model.getGameTime();
+        encoder.encode(model.tableRef(), model.getPlayer(), model.enemiesRef(), status);
+
+        if (t > 0) deltaBytes += encoder.delta().size();
+        //the stream arrives in two pieces, to exercise the splitting of messages
+        int half = encoder.delta().size() / 2;
+        follower.feed(encoder.delta().constData(), half);
+        QCOMPARE(follower.feed(encoder.delta().constData() + half, encoder.delta().size() - half), 1);
+        QVERIFY( follower.frame().table == model.getTable() );
+        QCOMPARE(follower.frame().player.x, model.getPlayer().x);
+        QCOMPARE(follower.frame().player.y, model.getPlayer().y);
+        QCOMPARE(follower.frame().enemies.size(), model.getEnemies().size());
+        for (int k = 0; k < model.getEnemies().size(); k++){
+            QCOMPARE(follower.frame().enemies[k].x, model.getEnemies()[k].x);
+            QCOMPARE(follower.frame().enemies[k].y, model.getEnemies()[k].y);
+            QCOMPARE(follower.frame().enemies[k].facing, model.getEnemies()[k].facing);
+        }
+        QCOMPARE(follower.frame().gameTime, model.getGameTime());
+
+        //the latecomer only gets some of the deltas until the keyframe of tick 40, then all of them
+        if (t == 40) QCOMPARE(latecomer.feed(encoder.keyframe().constData(), encoder.keyframe().size()), 1);
+        else if (t % 2 == 0 || t > 40) latecomer.feed(encoder.delta().constData(), encoder.delta().size());
+        if (t == 20) QVERIFY( !latecomer.synchronized() );
+    }
+    QVERIFY( latecomer.droppedMessages() > 0 );
+    QVERIFY( latecomer.synchronized() );
+    QCOMPARE(latecomer.tick(), encoder.tick());
+    QVERIFY( latecomer.frame().table == model.getTable() );
+    //the deltas are much smaller than the keyframes
+    QVERIFY( deltaBytes / 59 < encoder.keyframe().size() / 4 );
+}
+
+//a seek in a recording lands in the same state as the recorded game was in at that tick
+void BomberTest::replaySeeksToAnyTick(){
+    QTemporaryDir dir;
+    QString fileName = dir.path() + "/game.replay";
+    GameModel::Params params = {30,0,1,1,true};
+    GameModel game(10,0,1,1,false);
+    game.reset(params, 3);
+    game.setRollbackWindow(2048);
+    ReplayWriter writer;
+    QVERIFY( writer.open(fileName, game) );
+    game.setRecorder(&writer);
+
+    //back and forth in the corner, far from the enemy
+    for (int t = 0; t < 1000 && !game.gamePaused(); t++){
+        GameModel::Command c = {GameModel::Command::Move, (t / 3) % 2 ? GameModel::Left : GameModel::Right, false};
+        game.queueCommand(c);
+        game.advanceClock(125);
+    }
+    game.setRecorder(0);
+    writer.finish();
+    int recorded = game.getInputTicks();
+    QVERIFY( recorded > 2 * ReplayWriter::keyframeInterval );
+
+    //the states of the recorded game, taken from its rollback history (newest first)
+    int ticks[6] = {recorded - 1, 700, 513, 512, 300, 5};
+    QVector<GameModel::State> expected(6);
+    for (int i = 0; i < 6; i++){
+        QVERIFY( game.rollbackTo(ticks[i]) );
+        game.saveState(expected[i]);
+    }
+
+    ReplayReader reader;
+    QVERIFY( reader.open(fileName) );
+    QCOMPARE(reader.tickCount(), recorded);
+    QCOMPARE(reader.seed(), quint32(3));
+    GameModel replay(10,0,1,1,false);
+    int order[8] = {2, 5, 1, 0, 3, 4, 4, 2};
+    for (int n = 0; n < 8; n++){
+        int i = order[n];
+        QVERIFY( reader.seek(replay, ticks[i]) );
+        GameModel::State s;
+        replay.saveState(s);
+        QCOMPARE(s.tick, expected[i].tick);
+        QVERIFY( s.tiles == expected[i].tiles );
+        QCOMPARE(s.player.x, expected[i].player.x);
+        QCOMPARE(s.player.y, expected[i].player.y);
+        QCOMPARE(s.enemies.size(), expected[i].enemies.size());
+        for (int k = 0; k < s.enemies.size(); k++){
+            QCOMPARE(s.enemies[k].x, expected[i].enemies[k].x);
+            QCOMPARE(s.enemies[k].y, expected[i].enemies[k].y);
+        }
+        QCOMPARE(s.randomState, expected[i].randomState);
+        QCOMPARE(s.gameTime, expected[i].gameTime);
+    }
+    //no seek simulated more than a block
+    QVERIFY( reader.resimulatedTicks() < 8 * ReplayWriter::keyframeInterval );
+    QVERIFY( !reader.seek(replay, recorded + 1) );
+}
+
+//a game corrected by rollbacks is recorded as it was played in the end, not with the inputs it predicted
+void BomberTest::replayFollowsRollbacks(){
+    QTemporaryDir dir;
+    QString fileName = dir.path() + "/rollback.replay";
+    GameModel::Params params = {30,0,1,1,true};
+    GameModel game(10,0,1,1,false);
+    game.reset(params, 3);
+    game.setRollbackWindow(1024);
+    ReplayWriter writer;
+    QVERIFY( writer.open(fileName, game) );
+    game.setRecorder(&writer);
+
+    //the player stands still, then its moves arrive late: back to a tick of the block before the current one
+    for (int t = 0; t < 600 && !game.gamePaused(); t++) game.advanceClock(125);
+    int played = game.getInputTicks();
+    QVERIFY( played > 2 * ReplayWriter::keyframeInterval + 50 );
+    for (int t = 480; t < 560; t++){
+        GameModel::TickInput in = {false, qint8((t / 3) % 2 ? GameModel::Left : GameModel::Right)};
+        QVERIFY( game.correctInput(t, in) );
+    }
+    QCOMPARE(game.getInputTicks(), played);
+    game.setRecorder(0);
+    writer.finish();
+
+    int ticks[3] = {played - 1, 530, 300};
+    QVector<GameModel::State> expected(3);
+    for (int i = 0; i < 3; i++){
+        QVERIFY( game.rollbackTo(ticks[i]) );
+        game.saveState(expected[i]);
+    }
+    QVERIFY( expected[0].player.y != 1 );
+
+    ReplayReader reader;
+    QVERIFY( reader.open(fileName) );
+    QCOMPARE(reader.tickCount(), played);
+    GameModel replay(10,0,1,1,false);
+    for (int i = 0; i < 3; i++){
+        QVERIFY( reader.seek(replay, ticks[i]) );
+        GameModel::State s;
+        replay.saveState(s);
+        QCOMPARE(s.tick, expected[i].tick);
+        QVERIFY( s.tiles == expected[i].tiles );
+        QCOMPARE(s.player.x, expected[i].player.x);
+        QCOMPARE(s.player.y, expected[i].player.y);
+        QCOMPARE(s.randomState, expected[i].randomState);
+    }
+}
+
+//a designed level: the enemy is walled in two tiles below the player, inside the blast of an airstrike
+static const char pocketLevel[] =
+    "#########\n"
+    "#P......#\n"
+    "##......#\n"
+    "#E#.....#\n"
+    "##......#\n"
+    "#.....v.#\n"
+    "#.......#\n"
+    "#.......#\n"
+    "#########\n";
+
+void BomberTest::levelLoadsBothForms(){
+    GameModel::Params rules = {10, 0, 0, 1, false};
+    GameModel model(10,0,1,1,false);
+    LevelLoader loader;
+    QBuffer text;
+    text.setData(QByteArray(pocketLevel));
+    text.open(QIODevice::ReadOnly);
+    QVERIFY( loader.load(text, model, rules, 7) );
+    QCOMPARE(model.getSize(), 9);
+    QCOMPARE(model.getPlayer().x, 1);
+    QCOMPARE(model.getPlayer().y, 1);
+    QCOMPARE(model.getTable()[2][1], GameModel::Wall);
+    QCOMPARE(model.getTable()[2][2], GameModel::Floor);
+    QCOMPARE(model.getEnemies().size(), 2);
+    QCOMPARE(model.getEnemies()[0].x, 3);
+    QCOMPARE(model.getEnemies()[0].y, 1);
+    QCOMPARE(model.getEnemies()[0].facing, GameModel::Right);
+    QCOMPARE(model.getEnemies()[1].facing, GameModel::Down);
+    QCOMPARE(model.getParams().enemynum, 2);
+
+    //binary and back: the same level
+    QByteArray binary;
+    QBuffer out(&binary);
+    out.open(QIODevice::WriteOnly);
+    QVERIFY( LevelLoader::saveBinary(model, out) );
+    out.close();
+    QVERIFY( binary.size() < int(sizeof(pocketLevel)) );
+    GameModel copy(10,0,1,1,false);
+    QBuffer in(&binary);
+    in.open(QIODevice::ReadOnly);
+    QVERIFY( loader.load(in, copy, rules, 7) );
+    QByteArray saved;
+    QBuffer savedText(&saved);
+    savedText.open(QIODevice::WriteOnly);
+    QVERIFY( LevelLoader::saveText(copy, savedText) );
+    savedText.close();
+    //'E' is saved by its facing
+    QByteArray expected(pocketLevel);
+    expected.replace('E', '>');
+    QCOMPARE(saved, expected);
+
+    //broken levels are refused with the line at fault
+    QBuffer hole;
+    hole.setData(QByteArray("#####\n#P..#\n#....\n#####\n#####\n"));
+    hole.open(QIODevice::ReadOnly);
+    QVERIFY( !loader.load(hole, copy, rules, 7) );
+    QVERIFY( loader.errorString().startsWith("line 3") );
+    QBuffer ragged;
+    ragged.setData(QByteArray("#####\n#P.#\n"));
+    ragged.open(QIODevice::ReadOnly);
+    QVERIFY( !loader.load(ragged, copy, rules, 7) );
+    QVERIFY( loader.errorString().startsWith("line 2") );
+}
+
+//killEnemy on a fixed map: the same every time, whatever the seed
+void BomberTest::killEnemyOnFixedMap(){
+    GameModel::Params rules = {10, 0, 0, 1, false};
+    GameModel model(10,0,1,1,false);
+    LevelLoader loader;
+    QByteArray level(pocketLevel);
+    level.replace('v', '.');
+    QBuffer text(&level);
+    text.open(QIODevice::ReadOnly);
+    QVERIFY( loader.load(text, model, rules, 12345) );
+
+    model.airstrikeCalled();
+    for (int i = 0; i < 4; i++) model.playerMoved(GameModel::Right);
+    for (int i = 0; i < 5; i++) model.advanceGame();
+
+    QCOMPARE(model.getEnemies().size(), 0);
+    QVERIFY( !model.getPlayerDied() );
+    //the walls of the pocket weren't destroyed
+    QCOMPARE(model.getTable()[2][1], GameModel::Wall);
+}
+
+//the player's room is walled off from the enemies' room, so the game goes on for as long as the test needs
+static const char twoRoomLevel[] =
+    "############\n"
+    "#P....#....#\n"
+    "#.....#.E..#\n"
+    "#.....#....#\n"
+    "#.....#..E.#\n"
+    "#.....#....#\n"
+    "#.....#....#\n"
+    "#.....#.E..#\n"
+    "#.....#....#\n"
+    "#.....#....#\n"
+    "#.....#....#\n"
+    "############\n";
+
+//After a warm-up, the ticks of a game (enemy steps, seconds, airstrikes, moves, snapshots) allocate nothing.
+void BomberTest::zeroAllocationTicks(){
+#ifndef COUNT_ALLOCATIONS
+    QSKIP("counting the allocations needs glibc");
+#endif
+    GameModel::Params rules = {12, 0, 0, 4, false};
+    GameModel model(12,0,0,4,false);
+    model.setRollbackWindow(32);
+    LevelLoader loader;
+    QByteArray level(twoRoomLevel);
+    QBuffer text(&level);
+    text.open(QIODevice::ReadOnly);
+    QVERIFY( loader.load(text, model, rules, 99) );
+    GameModel::Command strike = {GameModel::Command::Airstrike, GameModel::Up, false};
+    GameModel::Command down = {GameModel::Command::Move, GameModel::Down, false};
+    GameModel::Command up = {GameModel::Command::Move, GameModel::Up, false};
+
+    //each round: an airstrike, out of its way, wait for it, and back; the first two are the warm-up
+    for (int round = 0; round < 6; round++){
+        if (round == 2) {
+            allocations = 0;
+            countAllocations = true;
+        }
+        model.queueCommand(strike);
+        for (int i = 0; i < 4; i++){
+            model.queueCommand(down);
+            model.advanceClock(125);
+        }
+        model.advanceClock(5000);
+        //getTable() would copy
+        QCOMPARE(model.tableRef()[1][1], GameModel::Floor);
+        for (int i = 0; i < 4; i++){
+            model.queueCommand(up);
+            model.advanceClock(125);
+        }
+    }
+    countAllocations = false;
+
+    QVERIFY( !model.gamePaused() );
+    QCOMPARE(model.getPlayer().x, 1);
+    QCOMPARE(model.getEnemies().size(), 3);
+    QVERIFY( model.getGameTime() > 30 );
+    QCOMPARE(allocations, 0);
+}
+
+//take() doesn't wait for the board, so the test does
+static bool takeBoard(BoardPregenerator &boards, const GameModel::Params &params, GameModel::State &board, quint32 &seed){
+    for (int wait = 0; wait < 10000; wait++){
+        if (boards.take(params, board, seed)) return true;
+        QThread::msleep(1);
+    }
+    return false;
+}
+
+//a game started on a board made in the background is the same game as one reset with the seed of the board
+void BomberTest::pregeneratedBoardMatchesReset(){
+    GameModel::Params params = {20, 60, 8, 2, false};
+    BoardPregenerator boards;
+    boards.prepare(params);
+    //asking again for the same board doesn't start another one
+    boards.prepare(params);
+    GameModel::State board;
+    quint32 seed = 0;
+    QVERIFY( takeBoard(boards, params, board, seed) );
+    QCOMPARE(boards.generatedBoards(), 1);
+
+    GameModel prepared(10,0,0,1,false);
+    QVERIFY( prepared.reset(params, seed, board) );
+    GameModel generated(10,0,0,1,false);
+    generated.reset(params, seed);
+    for (int step = 0; step < 3; step++){
+        GameModel::State a, b;
+        prepared.saveState(a);
+        generated.saveState(b);
+        QVERIFY( a.tiles == b.tiles );
+        QCOMPARE(a.enemies.size(), 8);
+        for (int k = 0; k < a.enemies.size(); k++){
+            QCOMPARE(a.enemies[k].x, b.enemies[k].x);
+            QCOMPARE(a.enemies[k].y, b.enemies[k].y);
+        }
+        QCOMPARE(a.randomState, b.randomState);
+        QCOMPARE(a.nextEnemyStep, b.nextEnemyStep);
+        prepared.advanceClock(700);
+        generated.advanceClock(700);
+    }
+
+    //the board was taken: the next one is for other settings, so there is none for these
+    GameModel::Params bigger = {24, 60, 8, 2, false};
+    boards.prepare(bigger);
+    QVERIFY( !boards.take(params, board, seed) );
+    //a board for other settings doesn't fit
+    QVERIFY( takeBoard(boards, bigger, board, seed) );
+    QVERIFY( !prepared.reset(params, seed, board) );
+}
+
+//the heatmap of a model on a fixed map, then of a batch: the workers' heatmaps add up to the same as one worker's
+void BomberTest::heatmapCountsGames(){
+    GameModel::Params rules = {10, 0, 0, 1, false};
+    GameModel model(10,0,1,1,false);
+    TileHeatmap heat;
+    model.setHeatmap(&heat);
+    LevelLoader loader;
+    QByteArray level(pocketLevel);
+    level.replace('v', '.');
+    QBuffer text(&level);
+    text.open(QIODevice::ReadOnly);
+    QVERIFY( loader.load(text, model, rules, 1) );
+    QCOMPARE(heat.size(), 9);
+    //killEnemyOnFixedMap: the enemy in the pocket is killed, the player is out of reach
+    model.airstrikeCalled();
+    for (int i = 0; i < 4; i++) model.playerMoved(GameModel::Right);
+    for (int i = 0; i < 5; i++) model.advanceGame();
+    QCOMPARE(heat.count(TileHeatmap::EnemyKills, 3, 1), quint64(1));
+    QCOMPARE(heat.total(TileHeatmap::EnemyKills), quint64(1));
+    QCOMPARE(heat.total(TileHeatmap::PlayerDeaths), quint64(0));
+    //the blast around (1,1) hits the inner tiles of rows and columns 1..4
+    QCOMPARE(heat.total(TileHeatmap::BlastHits), quint64(16));
+    QCOMPARE(heat.count(TileHeatmap::BlastHits, 4, 4), quint64(1));
+    QCOMPARE(heat.count(TileHeatmap::BlastHits, 5, 5), quint64(0));
+
+    //the binary form and back
+    QByteArray data;
+    QBuffer out(&data);
+    out.open(QIODevice::WriteOnly);
+    QVERIFY( heat.writeBinary(out) );
+    out.close();
+    TileHeatmap copy;
+    QBuffer in(&data);
+    in.open(QIODevice::ReadOnly);
+    QVERIFY( copy.readBinary(in) );
+    QCOMPARE(copy.size(), 9);
+    QCOMPARE(copy.count(TileHeatmap::EnemyKills, 3, 1), quint64(1));
+    QCOMPARE(copy.total(TileHeatmap::BlastHits), quint64(16));
+    QByteArray csv;
+    QBuffer csvOut(&csv);
+    csvOut.open(QIODevice::WriteOnly);
+    QVERIFY( heat.writeCsv(csvOut, TileHeatmap::BlastHits) );
+    csvOut.close();
+    QCOMPARE(csv.count('\n'), 9);
+    QVERIFY( csv.startsWith("0,0,0,0,0,0,0,0,0\n0,1,1,1,1,0,0,0,0\n") );
+
+    //the same games on one worker and on four: the same counts
+    GameModel::Params params = {15,10,3,2,true};
+    const int count = 64;
+    BatchEnvironment one(count, params, 1);
+    BatchEnvironment four(count, params, 4);
+    one.setHeatmapsEnabled(true);
+    four.setHeatmapsEnabled(true);
+    QVector<quint8> actions(count);
+    GameRandom random(11);
+    double rewards = 0;
+    for (int s = 0; s < 400; s++){
+        for (int e = 0; e < count; e++) actions[e] = quint8(random.bounded(6));
+        BatchEnvironment::StepResult r = one.step(actions.constData());
+        four.step(actions.constData());
+        for (int e = 0; e < count; e++) rewards += r.rewards[e];
+    }
+    TileHeatmap a, b;
+    one.collectHeatmap(a);
+    four.collectHeatmap(b);
+    QVERIFY( a.total(TileHeatmap::PlayerDeaths) > 0 );
+    QVERIFY( a.total(TileHeatmap::BlastHits) > 0 );
+    //+1 for a kill, -1 for a death
+    QCOMPARE(qint64(rewards), qint64(a.total(TileHeatmap::EnemyKills)) - qint64(a.total(TileHeatmap::PlayerDeaths)));
+    for (int c = 0; c < TileHeatmap::counterKinds; c++){
+        for (int i = 0; i < 15; i++){
+            for (int j = 0; j < 15; j++){
+                QCOMPARE(a.count(TileHeatmap::Counter(c), i, j), b.count(TileHeatmap::Counter(c), i, j));
+            }
+        }
+    }
+}
+
+//an enemy at the end of a corridor, one walled in, and a blast that destroys the walls
+static const char corridorLevel[] =
+    "#######\n"
+    "#P###^#\n"
+    "#.#####\n"
+    "#.##<.#\n"
+    "#.#####\n"
+    "#.....#\n"
+    "#######\n";
+
+//a blocked enemy only turns to where it can go: it never stands still twice in a row, unless walled in
+void BomberTest::blockedEnemiesTurnToOpenSide(){
+    GameModel::Params rules = {10, 0, 0, 1, true};
+    GameModel model(10,0,1,1,false);
+    LevelLoader loader;
+    QByteArray level(corridorLevel);
+    QBuffer text(&level);
+    text.open(QIODevice::ReadOnly);
+    QVERIFY( loader.load(text, model, rules, 3) );
+    QCOMPARE(model.getEnemies().size(), 2);
+
+    //an airstrike that reaches the walled in enemy's walls, but not the enemy, and back out of its way
+    for (int i = 0; i < 4; i++) model.playerMoved(GameModel::Down);
+    model.playerMoved(GameModel::Right);
+    model.airstrikeCalled();
+    model.playerMoved(GameModel::Left);
+    for (int i = 0; i < 4; i++) model.playerMoved(GameModel::Up);
+    QCOMPARE(model.getPlayer().x, 1);
+
+    //the corridor enemy turns to the only open side, walks, and turns back
+    model.advanceClock(1000);
+    QCOMPARE(model.getEnemies()[1].facing, GameModel::Right);
+    QCOMPARE(model.getEnemies()[1].y, 4);
+    model.advanceClock(1000);
+    QCOMPARE(model.getEnemies()[1].y, 5);
+    model.advanceClock(1000);
+    QCOMPARE(model.getEnemies()[1].facing, GameModel::Left);
+    //the walled in one has nowhere to turn
+    QCOMPARE(model.getEnemies()[0].facing, GameModel::Up);
+    QCOMPARE(model.getEnemies()[0].x, 1);
+
+    //the blast kills the corridor enemy, and opens the way below the other one, which takes it
+    model.advanceClock(1000);
+    QCOMPARE(model.getEnemies().size(), 1);
+    model.advanceClock(1000);
+    QCOMPARE(model.getEnemies()[0].facing, GameModel::Down);
+    model.advanceClock(1000);
+    QCOMPARE(model.getEnemies()[0].x, 2);
+    QCOMPARE(model.getEnemies()[0].y, 5);
+    QVERIFY( !model.getPlayerDied() );
+}
+
+static int observedStatusUpdates = 0;
+
+static void countStatusUpdates(const GameModel::Frame &, GameModel::Event e){
+    if (e == GameModel::StatusChanged) observedStatusUpdates++;
+}
+
+//The typed observers are called where the signals are emitted, with the model's own frame (not a copy of it).
+void BomberTest::observersSeeTheFrame(){
+    GameModel::Params rules = {10, 0, 0, 1, false};
+    GameModel model(10,0,1,1,false);
+    LevelLoader loader;
+    QByteArray level(pocketLevel);
+    level.replace('v', '.');
+    QBuffer text(&level);
+    text.open(QIODevice::ReadOnly);
+    QVERIFY( loader.load(text, model, rules, 12345) );
+
+    int tableUpdates = 0, endings = 0;
+    bool sameStorage = true, won = false;
+    int id = model.subscribe([&](const GameModel::Frame &f, GameModel::Event e){
+        sameStorage = sameStorage && &f.table == &model.tableRef() && &f.enemies == &model.enemiesRef();
+        if (e == GameModel::TableChanged) tableUpdates++;
+        if (e == GameModel::GameEnded) {
+            endings++;
+            won = f.ended && f.playerWon && f.bombedEnemies == 1;
+        }
+    });
+    observedStatusUpdates = 0;
+    model.subscribe(countStatusUpdates);
+
+    model.airstrikeCalled();
+    for (int i = 0; i < 4; i++) model.playerMoved(GameModel::Right);
+    QCOMPARE(tableUpdates, 4);
+    for (int i = 0; i < 5; i++) model.advanceGame();
+    QCOMPARE(endings, 0);
+    //the enemies' next step notices that they are all gone
+    model.advanceClock(1000);
+    QCOMPARE(endings, 1);
+    QVERIFY( won );
+    QVERIFY( sameStorage );
+    QCOMPARE(model.currentFrame().player.y, 5);
+
+    //unsubscribed observers aren't called any more
+    model.unsubscribe(id);
+    tableUpdates = 0;
+    model.requestUpdate();
+    QCOMPARE(tableUpdates, 0);
+    QCOMPARE(observedStatusUpdates, model.currentFrame().statusUpdates);
+}
+
+//The visible tiles depend on the viewport, not on the board, and the enemy grid finds exactly the enemies on them.
+void BomberTest::cameraShowsOnlyTheViewport(){
+    Camera camera;
+    camera.setViewport(400, 300);
+    camera.setBoardSize(100);
+    QCOMPARE(camera.tileSize(), int(Camera::minTileSize));
+    camera.follow(50, 50);
+    Camera::TileRange r = camera.visibleTiles();
+    int rows = r.bottom - r.top + 1, columns = r.right - r.left + 1;
+    QVERIFY( rows <= 300 / Camera::minTileSize + 2 && columns <= 400 / Camera::minTileSize + 2 );
+    QVERIFY( r.contains(50, 50) );
+    camera.setBoardSize(1000);
+    camera.follow(500, 500);
+    r = camera.visibleTiles();
+    QCOMPARE(r.bottom - r.top + 1, rows);
+    QCOMPARE(r.right - r.left + 1, columns);
+
+    //it doesn't scroll past the corner
+    camera.follow(0, 0);
+    QCOMPARE(camera.tilePosition(0, 0), QPoint(0, 0));
+    //a board that fits is shown whole, centered
+    camera.setBoardSize(10);
+    QCOMPARE(camera.tileSize(), 30);
+    QCOMPARE(camera.tilePosition(0, 0), QPoint(50, 0));
+    r = camera.visibleTiles();
+    QVERIFY( r.top == 0 && r.left == 0 && r.bottom == 9 && r.right == 9 );
+    camera.zoom(1);
+    QVERIFY( !camera.fitted() && camera.tileSize() > 30 );
+
+    //the enemies of a range come from an enemy map like the model's (1 + the facing, on the tiles with an enemy)
+    QVector<quint8> enemyMap(100 * 100, 0);
+    GameRandom random(5);
+    for (int k = 0; k < 300; k++) enemyMap[random.bounded(100) * 100 + random.bounded(100)] = quint8(1 + GameModel::Left);
+    Camera::TileRange range = {17, 41, 30, 77};
+    QVector<GameModel::Position> found;
+    findEnemies(enemyMap, 100, range, found);
+    int expected = 0;
+    for (int i = 0; i < 100; i++){
+        for (int j = 0; j < 100; j++) if (enemyMap[i * 100 + j] && range.contains(i, j)) expected++;
+    }
+    QVERIFY( expected > 0 );
+    QCOMPARE(found.size(), expected);
+    for (int k = 0; k < found.size(); k++){
+        QVERIFY( range.contains(found[k].x, found[k].y) );
+        QCOMPARE(found[k].facing, GameModel::Left);
+    }
+}
+
+//the model's enemy map has exactly its enemies, as they move, turn and die, and after a rollback
+static bool enemyMapMatches(const GameModel &model){
+    int n = model.getSize();
+    QVector<quint8> expected(n * n, 0);
+    foreach (const GameModel::Position &e, model.enemiesRef()) expected[e.x * n + e.y] = quint8(1 + e.facing);
+    return model.enemyMapRef() == expected;
+}
+
+void BomberTest::enemyMapFollowsEnemies(){
+    GameModel::Params params = {20,30,12,1,true};
+    GameModel model(10,0,1,1,false);
+    model.reset(params, 14);
+    model.setRollbackWindow(64);
+    QVERIFY( enemyMapMatches(model) );
+
+    //an airstrike in the middle of the enemies' area, where some of them get caught, and the player gets away
+    for (int t = 0; t < 12; t++) model.playerMoved(t % 2 ? GameModel::Right : GameModel::Down);
+    model.airstrikeCalled();
+    for (int t = 0; t < 4; t++) model.playerMoved(GameModel::Up);
+    int before = model.getEnemies().size();
+    for (int t = 0; t < 48; t++){
+        model.advanceClock(125);
+        QVERIFY( enemyMapMatches(model) );
+    }
+    QVERIFY( !model.getPlayerDied() );
+    QVERIFY( model.getEnemies().size() < before );
+
+    QVERIFY( model.rollbackTo(3) );
+    QVERIFY( enemyMapMatches(model) );
+    model.reset(params, 12);
+    QVERIFY( enemyMapMatches(model) );
+}
+
+static bool samePyramid(const MinimapPyramid &a, const MinimapPyramid &b){
+    if (a.levelCount() != b.levelCount()) return false;
+    for (int l = 0; l < a.levelCount(); l++){
+        for (int i = 0; i < a.levelSize(l); ++i){
+            for (int j = 0; j < a.levelSize(l); ++j){
+                if (a.walls(l, i, j) != b.walls(l, i, j) || a.explosions(l, i, j) != b.explosions(l, i, j)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+//The minimap kept up to date by the model (only where the tiles changed) is the same as one built from scratch.
+void BomberTest::minimapFollowsBlasts(){
+    GameModel model(100,0,0,1,true);
+    MinimapPyramid minimap, fresh;
+    model.setMinimap(&minimap);
+    QCOMPARE(minimap.levelCount(), 2);
+    QCOMPARE(minimap.overviewCells(), 50);
+    quint32 walls = 0;
+    for (int i = 0; i < 50; ++i) for (int j = 0; j < 50; ++j) walls += minimap.walls(1, i, j);
+    QCOMPARE(walls, quint32(4 * 99));
+
+    model.setTile(2, 2, GameModel::Wall);
+    model.setTile(60, 61, GameModel::Wall);
+    QCOMPARE(minimap.walls(1, 30, 30), quint32(1));
+
+    model.airstrikeCalled();
+    for (int i = 0; i < 4; i++) model.playerMoved(GameModel::Right);
+    for (int i = 0; i < 4; i++) model.advanceGame();
+    QVERIFY( minimap.explosions(1, 0, 0) > 0 );
+    fresh.reset(model.tableRef());
+    QVERIFY( samePyramid(minimap, fresh) );
+    QVector<quint8> overview;
+    minimap.writeOverview(overview);
+    QCOMPARE(overview.size(), 50 * 50);
+    QCOMPARE(overview[0], MinimapPyramid::explosionCell);
+    QCOMPARE(int(overview[3 * 50 + 3]), 0);
+
+    //the blast is over, and the wall it hit is gone
+    model.advanceGame();
+    QVERIFY( !model.getPlayerDied() );
+    QCOMPARE(minimap.walls(1, 1, 1), quint32(0));
+    fresh.reset(model.tableRef());
+    QVERIFY( samePyramid(minimap, fresh) );
+}
+
+//the color of the pixel in the middle of tile (x,y)
+static QRgb tileColor(const RgbImage &image, int tileSize, int x, int y){
+    const uchar* d = image.pixels.constData() + ((x * tileSize + tileSize / 2) * image.width + y * tileSize + tileSize / 2) * 3;
+    return qRgb(d[0], d[1], d[2]);
+}
+
+//The frames are drawn like the board of the GUI, and every one of them is written by the encoder threads.
+void BomberTest::exporterWritesFrames(){
+    GameModel model(10,5,3,2,false);
+    model.reset(model.getParams(), 77);
+    FrameRasterizer rasterizer(8);
+    RgbImage image;
+    rasterizer.render(model.tableRef(), model.getPlayer(), model.enemiesRef(), image);
+    QCOMPARE(image.width, 80);
+    QCOMPARE(image.pixels.size(), 80 * 80 * 3);
+    QCOMPARE(tileColor(image, 8, 0, 0), qRgb(139, 139, 139));
+    QCOMPARE(tileColor(image, 8, 1, 1), qRgb(0, 70, 197));
+    GameModel::Position e = model.getEnemies()[0];
+    QCOMPARE(tileColor(image, 8, e.x, e.y), qRgb(193, 0, 0));
+
+    QTemporaryDir dir;
+    FrameExporter exporter(dir.path() + "/frames", FrameExporter::Ppm, 4, 2);
+    for (int t = 0; t < 20; t++){
+        exporter.exportFrame(t, model);
+        model.advanceClock(125);
+    }
+    QVERIFY( exporter.waitForDone() );
+    QCOMPARE(exporter.writtenFrames(), 20);
+    QFile file(exporter.fileName(7));
+    QVERIFY( file.fileName().endsWith("frame_000007.ppm") );
+    QVERIFY( file.open(QIODevice::ReadOnly) );
+    QByteArray data = file.readAll();
+    QByteArray header("P6\n40 40\n255\n");
+    QVERIFY( data.startsWith(header) );
+    QCOMPARE(data.size(), header.size() + 40 * 40 * 3);
+}
+
+void BomberTest::tunerStopsEarly(){
+    WinRateTest wins(0.4, 0.6, 0.05, 0.05), losses(0.4, 0.6, 0.05, 0.05), even(0.4, 0.6, 0.05, 0.05);
+    for (int g = 0; g < 100; g++){
+        wins.add(true);
+        losses.add(false);
+        even.add(g % 2 == 0);
+    }
+    QCOMPARE(wins.decision(), WinRateTest::High);
+    QCOMPARE(losses.decision(), WinRateTest::Low);
+    QCOMPARE(even.decision(), WinRateTest::Undecided);
+    QVERIFY( wins.games() < 10 );
+    QCOMPARE(losses.games(), wins.games());
+
+    DifficultyTuner::Settings settings;
+    settings.parallelGames = 16;
+    settings.maxGames = 400;
+    settings.threads = 2;
+    DifficultyTuner tuner(settings);
+    //(at speed 1 the player only gets three moves before the blast, too few to get out of it)
+    GameModel::Params easy = {10, 0, 1, 3, true};
+    DifficultyTuner::Result r = tuner.evaluate(easy, 5);
+    QCOMPARE(r.verdict, DifficultyTuner::TooEasy);
+    QVERIFY( r.games < settings.maxGames );
+    GameModel::Params hard = {10, 0, 10, 7, true};
+    r = tuner.evaluate(hard, 5);
+    QCOMPARE(r.verdict, DifficultyTuner::TooHard);
+    QVERIFY( tuner.totalGames() < 2 * settings.maxGames );
+}
+
+void BomberTest::estimatorWeighsMoves(){
+    //an enemy two tiles to the right of the player, coming left: stepping right walks into it
+    GameModel model(10,0,1,3,true);
+    model.reset(model.getParams(), 21);
+    GameModel::State s;
+    model.saveState(s);
+    GameModel::Position enemy = {1, 3, GameModel::Left};
+    s.enemies.resize(1);
+    s.enemies[0] = enemy;
+
+    WinEstimator estimator(50, 60, 2);
+    WinEstimator::Estimate e;
+    estimator.compute(model.getParams(), s, 1, e);
+    QVERIFY( e.valid );
+    QCOMPARE(e.playouts, 250);
+    QCOMPARE(e.risk[BatchEnvironment::MoveRight], 1.0);
+    QVERIFY( e.risk[BatchEnvironment::MoveDown] < 1.0 );
+    QVERIFY( e.winChance > 0 && e.winChance < 1 );
+
+    //the same in the background
+    estimator.submit(model.getParams(), s);
+    for (int wait = 0; wait < 10000 && !estimator.fetchEstimate(); wait++) QThread::msleep(1);
+    QCOMPARE(estimator.finishedEstimates(), 1);
+    QCOMPARE(estimator.estimate().risk[BatchEnvironment::MoveRight], 1.0);
+
+    GameModel::State fromFrame;
+    WinEstimator::stateFromFrame(model.currentFrame(), fromFrame);
+    QCOMPARE(fromFrame.tiles, s.tiles);
+    QCOMPARE(fromFrame.player.x, 1);
+}
+
+void BomberTest::estimatorReadsThreadedFrames(){
+    //the worker publishes into the frames of the simulation thread; the thread itself isn't started
+    GameModel model(10,0,1,3,true);
+    model.reset(model.getParams(), 21);
+    SimulationThread thread(10,0,1,3,true,1);
+    SimulationWorker worker(&model, &thread);
+
+    //the airstrike is called two tiles down, then the player steps away from it
+    model.playerMoved(GameModel::Down);
+    model.playerMoved(GameModel::Down);
+    model.airstrikeCalled();
+    model.playerMoved(GameModel::Right);
+    QVERIFY( thread.fetchFrame() );
+    QCOMPARE(thread.frame().target.x, 3);
+    QCOMPARE(thread.frame().target.y, 1);
+    QCOMPARE(thread.frame().player.y, 2);
+
+    //the estimate from the published frame is the same as the one from the model's own
+    GameModel::State published, own;
+    WinEstimator::stateFromFrame(thread.frame(), published);
+    WinEstimator::stateFromFrame(model.currentFrame(), own);
+    //(an estimator for each: the bot of an estimator breaks ties from one random sequence, call after call)
+    WinEstimator first(50, 60, 2), second(50, 60, 2);
+    WinEstimator::Estimate a, b;
+    first.compute(model.getParams(), published, 5, a);
+    second.compute(model.getParams(), own, 5, b);
+    QCOMPARE(a.winChance, b.winChance);
+    for (int k = 0; k < 5; k++) QCOMPARE(a.risk[k], b.risk[k]);
+}
+
+void BomberTest::chargesChainReact(){
+    //a line of charges from the player to an enemy, and one charge out of reach; no inner walls
+    QByteArray level;
+    for (int i = 0; i < 20; i++){
+        QByteArray row(20, i == 0 || i == 19 ? '#' : '.');
+        row[0] = '#';
+        row[19] = '#';
+        level += row;
+        level += '\n';
+    }
+    const int charges[7][2] = {{2,5}, {2,8}, {2,11}, {2,14}, {5,14}, {8,14}, {15,2}};
+    for (int k = 0; k < 7; k++) level[charges[k][0] * 21 + charges[k][1]] = 'T';
+    level[2 * 21 + 2] = 'P';
+    level[10 * 21 + 16] = '>';
+    level[17 * 21 + 17] = '>';
+
+    //walls can't be destroyed: a tile stamped by two blasts would be left a wall
+    GameModel::Params rules = {20, 0, 0, 1, false};
+    GameModel model(20,0,0,1,false);
+    LevelLoader loader;
+    QBuffer text;
+    text.setData(level);
+    text.open(QIODevice::ReadOnly);
+    QVERIFY( loader.load(text, model, rules, 3) );
+    QCOMPARE(model.chargesRef().size(), 7);
+    QCOMPARE(model.getTable()[8][14], GameModel::TargetFloor);
+
+    model.airstrikeCalled();
+    for (int k = 0; k < 4; k++) model.playerMoved(GameModel::Down);
+    for (int k = 0; k < 4; k++) model.advanceGame();
+    QVERIFY( !model.getPlayerDied() );
+    QCOMPARE(model.getEnemies().size(), 1);
+    QCOMPARE(model.getEnemies()[0].x, 17);
+    QCOMPARE(model.chargesRef().size(), 1);
+    QCOMPARE(model.getTable()[11][17], GameModel::FloorUnderExplosion);
+    QCOMPARE(model.getTable()[12][17], GameModel::Floor);
+    QCOMPARE(model.getTable()[15][2], GameModel::TargetFloor);
+
+    //the explosion survives a save and a restore
+    GameModel::State s;
+    model.saveState(s);
+    QCOMPARE(s.blasts.size(), 7);
+    QVERIFY( model.restoreState(s) );
+
+    model.advanceGame();
+    QVector< QVector<GameModel::TileType> > t = model.getTable();
+    for (int i = 1; i < 19; i++){
+        for (int j = 1; j < 19; j++){
+            QCOMPARE(t[i][j], i == 15 && j == 2 ? GameModel::TargetFloor : GameModel::Floor);
+        }
+    }
+}
+
+void BomberTest::stencilsShapeTheBlast(){
+    //one span per row for the built-in shapes, however they are made
+    BlastStencil diamond(BlastStencil::Diamond, 3);
+    QCOMPARE(diamond.spans().size(), 7);
+    QCOMPARE(diamond.tileCount(), 25);
+    QVERIFY( diamond.covers(1, -2) );
+    QVERIFY( !diamond.covers(2, -2) );
+    QCOMPARE(BlastStencil(BlastStencil::Cross, 4).tileCount(), 17);
+    BlastStencil square;
+    QVERIFY( BlastStencil::custom(BlastStencil(BlastStencil::Square, 3).rows(), square) );
+    QVERIFY( square == BlastStencil() );
+    QList<QByteArray> even;
+    even << "XX" << "XX";
+    QVERIFY( !BlastStencil::custom(even, square) );
+
+    //a ring with gaps: two spans on some rows
+    QList<QByteArray> rows;
+    rows << "XX.XX" << "X...X" << "..X.." << "X...X" << "XX.XX";
+    BlastStencil ring;
+    QVERIFY( BlastStencil::custom(rows, ring) );
+    QCOMPARE(ring.spans().size(), 9);
+    QCOMPARE(ring.rows(), rows);
+
+    QByteArray level;
+    for (int i = 0; i < 15; i++){
+        QByteArray row(15, i == 0 || i == 14 ? '#' : '.');
+        row[0] = '#';
+        row[14] = '#';
+        level += row;
+        level += '\n';
+    }
+    level[7 * 16 + 7] = 'P';
+    level[7 * 16 + 9] = '>';
+    level[9 * 16 + 8] = '>';
+    GameModel::Params rules = {15, 0, 0, 1, false};
+    GameModel model(15,0,0,1,false);
+    LevelLoader loader;
+    QBuffer text;
+    text.setData(level);
+    text.open(QIODevice::ReadOnly);
+    QVERIFY( loader.load(text, model, rules, 3) );
+    QVERIFY( model.setBlastStencil(ring) );
+
+    //the player hides in the gap next to the target; the enemy in the gap lives, the other one doesn't
+    model.airstrikeCalled();
+    //the shape can't change under an airstrike on its way
+    QVERIFY( !model.setBlastRadius(1) );
+    model.playerMoved(GameModel::Up);
+    for (int k = 0; k < 4; k++) model.advanceGame();
+    QVERIFY( !model.getPlayerDied() );
+    QCOMPARE(model.getEnemies().size(), 1);
+    QCOMPARE(model.getEnemies()[0].y, 9);
+    QVector< QVector<GameModel::TileType> > t = model.getTable();
+    for (int i = 1; i < 14; i++){
+        for (int j = 1; j < 14; j++){
+            QCOMPARE(t[i][j], ring.covers(i - 7, j - 7) ? GameModel::FloorUnderExplosion : GameModel::Floor);
+        }
+    }
+    model.advanceGame();
+    QCOMPARE(model.getTable()[9][8], GameModel::Floor);
+    for (int i = 1; i < 14; i++){
+        for (int j = 1; j < 14; j++) QCOMPARE(model.getTable()[i][j], GameModel::Floor);
+    }
+
+    //near the edge the spans are cut off by the outer walls, the same way on either kind of table
+    QVector< QVector<GameModel::TileType> > a = model.getTable();
+    QVector<quint8> cells(15 * 15);
+    for (int i = 0; i < 15; i++){
+        for (int j = 0; j < 15; j++) cells[i*15 + j] = quint8(a[i][j]);
+    }
+    FlatTable<quint8> b = {cells.data(), 15};
+    selectBlastFunctions(true)->apply(a, 15, diamond, 1, 2);
+    BlastKernel<true>::apply(b, 15, diamond, 1, 2);
+    for (int i = 0; i < 15; i++){
+        for (int j = 0; j < 15; j++){
+            QCOMPARE(int(cells[i*15 + j]), int(a[i][j]));
+            bool inner = i > 0 && i < 14 && j > 0 && j < 14;
+            QCOMPARE(a[i][j] == GameModel::FloorUnderExplosion, inner && diamond.covers(i - 1, j - 2));
+        }
+    }
+}
+
+void BomberTest::modelAndBatchAgree(){
+    DifferentialTester::Settings settings;
+    settings.games = 300;
+    settings.maxSteps = 200;
+    settings.gamesPerRound = 16;
+    settings.threads = 2;
+    DifferentialTester tester(settings);
+    DifferentialTester::Report report = tester.run(11);
+    QCOMPARE(report.games, qint64(300));
+    QVERIFY( report.steps > 0 );
+    QVERIFY( report.divergences.isEmpty() );
+
+    //a trace is read back as it was written
+    DifferentialTester::Trace trace;
+    QVERIFY( DifferentialTester::parseTrace("10 0 1 3 1 diamond2 7 ..RRDA..", trace) );
+    QCOMPARE(trace.params.enemyspd, 3);
+    QVERIFY( trace.stencil == BlastStencil(BlastStencil::Diamond, 2) );
+    QCOMPARE(trace.actions.size(), 8);
+    QCOMPARE(int(trace.actions[5]), int(BatchEnvironment::CallAirstrike));
+    QCOMPARE(DifferentialTester::formatTrace(trace), QByteArray("10 0 1 3 1 diamond2 7 ..RRDA.."));
+    QVERIFY( !DifferentialTester::parseTrace("10 0 1 3 1 ring2 7 ..", trace) );
+    QVERIFY( !DifferentialTester::parseTrace("10 0 1 3 1 square3 7 ..X", trace) );
+
+    //an airstrike the player runs from, until the game ends
+    QVERIFY( DifferentialTester::parseTrace("12 10 3 2 0 square3 5 ARRRRDDDD", trace) );
+    for (int k = 0; k < 200; k++) trace.actions.append(quint8(k % 10 == 0 ? BatchEnvironment::CallAirstrike : BatchEnvironment::Stay));
+    QCOMPARE(DifferentialTester::replay(trace), -1);
+}
+
 void BomberTest::cleanupTestCase(){
     delete _model;
     delete _model2;
@@ -214,6 +1658,28 @@ void BomberTest::cleanupTestCase(){
     delete _model4;
 }
 
+//the model changes between two display frames make one repaint; the counts tell how many were merged
+void BomberTest::schedulerMergesUpdates(){
+    //the scheduler isn't started: the display frames are driven by hand
+    FrameScheduler scheduler;
+    scheduler.markDirty();
+    scheduler.markDirty();
+    scheduler.markDirty();
+    scheduler.displayRefresh();
+    QCOMPARE(scheduler.presentedFrames(), 1);
+    //nothing changed since
+    scheduler.displayRefresh();
+    QCOMPARE(scheduler.presentedFrames(), 1);
+
+    //four frames published by the simulation thread since the last poll, one shown
+    scheduler.markDirty(4);
+    scheduler.markDirty(0);
+    scheduler.displayRefresh();
+    QCOMPARE(scheduler.requestedUpdates(), 7);
+    QCOMPARE(scheduler.presentedFrames(), 2);
+    QCOMPARE(scheduler.coalescedUpdates(), 5);
+}
+
 
 QTEST_APPLESS_MAIN(BomberTest)
 
@@ -0,0 +1,43 @@
+#-------------------------------------------------
+#
+# Measures the difficulty of the game settings with a scripted player
+#
+#-------------------------------------------------
+
+QT       += core
+QT       -= gui
+
+TARGET = bombertune
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+
+SOURCES += \
+    bombertune.cpp \
+    ../gamemodel.cpp \
+    ../blaststencil.cpp \
+    ../replay.cpp \
+    ../tileheatmap.cpp \
+    ../minimap.cpp \
+    ../inputqueue.cpp \
+    ../batchenvironment.cpp \
+    ../referencebot.cpp \
+    ../difficultytuner.cpp
+HEADERS += \
+    ../gamemodel.h \
+    ../replay.h \
+    ../tileheatmap.h \
+    ../minimap.h \
+    ../inputqueue.h \
+    ../gamerandom.h \
+    ../blastkernel.h \
+    ../blaststencil.h \
+    ../openmask.h \
+    ../batchenvironment.h \
+    ../referencebot.h \
+    ../difficultytuner.h
+INCLUDEPATH += ..
+
+CONFIG += C++11
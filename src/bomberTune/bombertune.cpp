@@ -0,0 +1,40 @@
+#include <QCoreApplication>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include "difficultytuner.h"
+
+//Finds, for each board size, enemy speed and wall count, the number of enemies the ReferenceBot beats at the target rate.
+//Prints one line per configuration: size, walls, speed, enemies, the verdict and the measured win rate.
+//usage: bombertune [target win rate] [margin] [threads] [games at once] [max games]
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QStringList args = a.arguments();
+    DifficultyTuner::Settings settings;
+    if (args.size() > 1) settings.targetWinRate = args[1].toDouble();
+    if (args.size() > 2) settings.margin = args[2].toDouble();
+    if (args.size() > 3) settings.threads = args[3].toInt();
+    if (args.size() > 4) settings.parallelGames = args[4].toInt();
+    if (args.size() > 5) settings.maxGames = args[5].toInt();
+
+    QVector<int> sizes, speeds;
+    for (int size = 10; size <= 30; size += 5) sizes.append(size);
+    for (int speed = 1; speed <= 7; speed += 2) speeds.append(speed);
+
+    DifficultyTuner tuner(settings);
+    QElapsedTimer timer;
+    timer.start();
+    QVector<DifficultyTuner::Result> results = tuner.sweep(sizes, speeds, 1);
+    qint64 ms = qMax(qint64(1), timer.elapsed());
+
+    static const char* verdicts[] = {"too easy", "too hard", "on target"};
+    QTextStream out(stdout);
+    out << "size\twalls\tspeed\tenemies\tverdict\twin rate" << endl;
+    foreach (const DifficultyTuner::Result &r, results){
+        out << r.params.size << '\t' << r.params.wallnum << '\t' << r.params.enemyspd << '\t' << r.params.enemynum << '\t'
+            << verdicts[r.verdict] << '\t' << (r.games > 0 ? double(r.wins) / r.games : 0.0) << " (" << r.games << " games)" << endl;
+    }
+    out << tuner.totalGames() << " games, " << tuner.totalSteps() << " steps in " << ms << " ms" << endl;
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include "camera.h"
+#include <QtMath>
+
+//the tile that pixel 'p' of the board is on (the pixel can be left of or above the board)
+static int tileOf(int p, int tileSize){
+    return p >= 0 ? p / tileSize : -((tileSize - 1 - p) / tileSize);
+}
+
+
+Camera::Camera():
+    width(0), height(0), n(0), ts(minTileSize), fit(true), focusX(0), focusY(0), scrollLeft(0), scrollTop(0)
+{
+}
+
+
+void Camera::setViewport(int width, int height){
+    this->width = qMax(0, width);
+    this->height = qMax(0, height);
+    update();
+}
+
+
+void Camera::setBoardSize(int n){
+    this->n = qMax(0, n);
+    update();
+}
+
+
+void Camera::zoom(int steps){
+    if (steps == 0) return;
+    int size = qRound(ts * qPow(1.25, steps));
+    //small tiles would not change by rounding
+    if (size == ts) size += steps > 0 ? 1 : -1;
+    ts = qBound(int(minTileSize), size, int(maxTileSize));
+    fit = false;
+    update();
+}
+
+
+void Camera::zoomToFit(){
+    fit = true;
+    update();
+}
+
+
+void Camera::follow(int x, int y){
+    focusX = x;
+    focusY = y;
+    update();
+}
+
+
+Camera::TileRange Camera::visibleTiles() const{
+    TileRange r;
+    r.top = qMax(0, tileOf(scrollTop, ts));
+    r.bottom = qMin(n - 1, tileOf(scrollTop + height - 1, ts));
+    r.left = qMax(0, tileOf(scrollLeft, ts));
+    r.right = qMin(n - 1, tileOf(scrollLeft + width - 1, ts));
+    return r;
+}
+
+
+//Recalculates the tile size (when fitting the board) and the scroll position.
+void Camera::update(){
+    if (fit && n > 0) ts = qBound(int(minTileSize), qMin(width, height) / n, int(maxTileSize));
+    scrollLeft = scrollTo(focusY, width);
+    scrollTop = scrollTo(focusX, height);
+}
+
+
+//The scroll position along one axis that puts 'tile' in the middle of the viewport, clamped to the board.
+int Camera::scrollTo(int tile, int viewport) const{
+    int board = n * ts;
+    if (board <= viewport) return (board - viewport) / 2;
+    return qBound(0, tile * ts + ts / 2 - viewport / 2, board - viewport);
+}
+
+
+
+void findEnemies(const QVector<quint8> &enemyMap, int boardSize, const Camera::TileRange &range, QVector<GameModel::Position> &out){
+    out.erase(out.begin(), out.end()); //keeps the capacity
+    if (range.isEmpty() || enemyMap.size() != boardSize * boardSize) return;
+    for (int i = range.top; i <= range.bottom; ++i){
+        const quint8* row = enemyMap.constData() + i * boardSize;
+        for (int j = range.left; j <= range.right; ++j){
+            if (!row[j]) continue;
+            GameModel::Position e = {i, j, GameModel::Direction(row[j] - 1)};
+            out.push_back(e);
+        }
+    }
+}
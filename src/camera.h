@@ -0,0 +1,59 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <QVector>
+#include <QPoint>
+#include "gamemodel.h"
+
+//The part of the board that is shown in a viewport: 'tileSize' pixels per tile (the zoom), scrolled so that
+//the followed tile (the player) is in the middle, but never past the edges of the board.
+//A board smaller than the viewport is centered in it. Until the user zooms, the tile size fits the whole board
+//into the viewport, as long as that doesn't make the tiles smaller than minTileSize.
+//Like the model, x is the row and y is the column of a tile; the pixels are horizontal, then vertical.
+class Camera
+{
+public:
+    static const int minTileSize = 8;
+    static const int maxTileSize = 128;
+
+    //rows [top, bottom] and columns [left, right]; empty if top > bottom or left > right
+    struct TileRange{
+        int top, bottom, left, right;
+        bool isEmpty() const {return top > bottom || left > right;}
+        bool contains(int x, int y) const {return x >= top && x <= bottom && y >= left && y <= right;}
+    };
+
+    Camera();
+    void setViewport(int width, int height);
+    void setBoardSize(int n);
+    //multiplies the tile size by 1.25 'steps' times (divides with negative steps)
+    void zoom(int steps);
+    void zoomToFit();
+    void follow(int x, int y);
+
+    int tileSize() const {return ts;}
+    bool fitted() const {return fit;}
+    //the tiles that are at least partly in the viewport
+    TileRange visibleTiles() const;
+    //the top left pixel of tile (x,y) in the viewport
+    QPoint tilePosition(int x, int y) const {return QPoint(y * ts - scrollLeft, x * ts - scrollTop);}
+
+private:
+    int width, height;
+    int n;
+    int ts;
+    bool fit;
+    int focusX, focusY;
+    int scrollLeft, scrollTop; //the pixel of the board at the top left corner of the viewport
+
+    void update();
+    int scrollTo(int tile, int viewport) const;
+};
+
+
+//Replaces the contents of 'out' with the enemies in 'range', found by the enemy map of the model (see
+//GameModel::enemyMapRef): only the tiles of the range are looked at, whatever the size of the board and the number
+//of enemies. The model keeps the map up to date as the enemies move and die, so nothing is built for a frame.
+void findEnemies(const QVector<quint8> &enemyMap, int boardSize, const Camera::TileRange &range, QVector<GameModel::Position> &out);
+
+#endif // CAMERA_H
@@ -0,0 +1,384 @@
+#include "differentialtester.h"
+#include <QThread>
+#include <QList>
+
+static const char actionChars[6] = {'.', 'U', 'R', 'D', 'L', 'A'};
+static const char* shapeNames[3] = {"square", "cross", "diamond"};
+
+//FNV-1a, a value at a time
+class StateHash
+{
+public:
+    StateHash(): h(14695981039346656037ull) {}
+    void add(qint64 v) {h = (h ^ quint64(v)) * 1099511628211ull;}
+    quint64 value() const {return h;}
+private:
+    quint64 h;
+};
+
+
+DifferentialTester::DifferentialTester(const Settings &settings):
+    _settings(settings), _seed(0), divergences(0)
+{
+    _settings.gamesPerRound = qMax(1, _settings.gamesPerRound);
+}
+
+
+//The rounds are shared out among the workers up front, so each one only touches its own counters and findings.
+DifferentialTester::Report DifferentialTester::run(quint32 seed){
+    _seed = seed;
+    divergences.storeRelease(0);
+    qint64 rounds = (_settings.games + _settings.gamesPerRound - 1) / _settings.gamesPerRound;
+    int threads = _settings.threads > 0 ? _settings.threads : QThread::idealThreadCount();
+    int workerCount = int(qBound(qint64(1), qint64(threads), qMax(qint64(1), rounds)));
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(workerCount);
+    QVector<Worker*> workers;
+    for (int w = 0; w < workerCount; w++){
+        Worker* worker = new Worker();
+        worker->setAutoDelete(false);
+        worker->owner = this;
+        worker->first = w;
+        worker->workers = workerCount;
+        worker->games = 0;
+        worker->steps = 0;
+        workers.append(worker);
+        pool.start(worker);
+    }
+    pool.waitForDone();
+
+    Report report;
+    report.games = 0;
+    report.steps = 0;
+    foreach (Worker* worker, workers){
+        report.games += worker->games;
+        report.steps += worker->steps;
+        foreach (const Divergence &d, worker->found){
+            if (report.divergences.size() < _settings.maxDivergences) report.divergences.append(d);
+        }
+        delete worker;
+    }
+    return report;
+}
+
+
+//One round: 'gamesPerRound' games on the same rules, stepped together. A game is dropped when it ends the same way
+//on both engines, when it differs (and is minimized then), or after 'maxSteps' steps.
+void DifferentialTester::Worker::run(){
+    const Settings &s = owner->_settings;
+    qint64 rounds = (s.games + s.gamesPerRound - 1) / s.gamesPerRound;
+    QVector<GameModel*> models;
+    GameModel::State state;
+
+    for (qint64 round = first; round < rounds && owner->divergences.loadAcquire() < s.maxDivergences; round += workers){
+        GameRandom random(owner->_seed ^ quint32(round * 2654435761u));
+        Trace rules;
+        rules.params = randomParams(random);
+        rules.stencil = randomStencil(random);
+        int count = int(qMin(qint64(s.gamesPerRound), s.games - round * s.gamesPerRound));
+        while (models.size() < count) models.append(new GameModel(10, 0, 1, 1, false));
+
+        BatchEnvironment env(count, rules.params, 1, rules.stencil);
+        QVector<Trace> traces(count, rules);
+        QVector<quint8> live(count, 1);
+        QVector<quint8> actions(count, quint8(BatchEnvironment::Stay));
+        for (int e = 0; e < count; e++){
+            traces[e].seed = quint32(random.bounded(0x7FFFFFFF));
+            env.restartGame(e, traces[e].seed);
+            startModel(*models[e], traces[e]);
+        }
+
+        int remaining = count;
+        for (int step = 0; step < s.maxSteps && remaining > 0; step++){
+            for (int e = 0; e < count; e++){
+                if (!live[e]) {
+                    actions[e] = BatchEnvironment::Stay;
+                } else if (random.bounded(1000) < int(s.airstrikeRate * 1000)) {
+                    actions[e] = BatchEnvironment::CallAirstrike;
+                } else {
+                    actions[e] = quint8(random.bounded(5));
+                }
+            }
+            BatchEnvironment::StepResult r = env.step(actions.constData());
+
+            for (int e = 0; e < count; e++){
+                if (!live[e]) continue;
+                traces[e].actions.append(actions[e]);
+                models[e]->stepInputTick(tickInput(actions[e]));
+                steps++;
+                Outcome outcome = compareStep(*models[e], state, env, e, r, 0);
+                if (outcome == Going) continue;
+                live[e] = 0;
+                remaining--;
+                if (outcome == Differs){
+                    Divergence d;
+                    d.trace = minimize(traces[e]);
+                    d.step = replay(d.trace, &d.difference);
+                    found.append(d);
+                    owner->divergences.ref();
+                }
+            }
+        }
+        games += count;
+    }
+    foreach (GameModel* model, models) delete model;
+}
+
+
+int DifferentialTester::replay(const Trace &trace, QString* difference){
+    const GameModel::Params &p = trace.params;
+    GameModel model(p.size, p.wallnum, p.enemynum, p.enemyspd, p.destroywalls);
+    startModel(model, trace);
+    BatchEnvironment env(1, p, 1, trace.stencil);
+    env.restartGame(0, trace.seed);
+    GameModel::State state;
+
+    for (int i = 0; i < trace.actions.size(); i++){
+        quint8 action = trace.actions[i];
+        BatchEnvironment::StepResult r = env.step(&action);
+        model.stepInputTick(tickInput(action));
+        Outcome outcome = compareStep(model, state, env, 0, r, difference);
+        if (outcome == Differs) return i;
+        if (outcome == Ended) break;
+    }
+    return -1;
+}
+
+
+//Cuts the trace at its divergence, then goes over the actions from the last one back, leaving each one out,
+//or else turning it into standing still, if the trace still differs without it; until a pass changes nothing.
+DifferentialTester::Trace DifferentialTester::minimize(const Trace &trace){
+    Trace best = trace;
+    int at = replay(best);
+    if (at < 0) return best;
+    best.actions.resize(at + 1);
+
+    bool changed = true;
+    while (changed){
+        changed = false;
+        for (int i = best.actions.size() - 1; i >= 0; i--){
+            if (i >= best.actions.size()) continue;
+            Trace shorter = best;
+            shorter.actions.remove(i);
+            at = replay(shorter);
+            if (at >= 0){
+                shorter.actions.resize(at + 1);
+                best = shorter;
+                changed = true;
+                continue;
+            }
+            if (best.actions[i] == BatchEnvironment::Stay) continue;
+            Trace still = best;
+            still.actions[i] = BatchEnvironment::Stay;
+            at = replay(still);
+            if (at >= 0){
+                still.actions.resize(at + 1);
+                best = still;
+                changed = true;
+            }
+        }
+    }
+    return best;
+}
+
+
+
+QByteArray DifferentialTester::formatTrace(const Trace &trace){
+    const GameModel::Params &p = trace.params;
+    QByteArray line;
+    line += QByteArray::number(p.size) + ' ' + QByteArray::number(p.wallnum) + ' ' + QByteArray::number(p.enemynum) + ' '
+          + QByteArray::number(p.enemyspd) + ' ' + QByteArray::number(int(p.destroywalls)) + ' ';
+    int shape = trace.stencil.shape() == BlastStencil::Custom ? 0 : int(trace.stencil.shape());
+    line += QByteArray(shapeNames[shape]) + QByteArray::number(trace.stencil.radius()) + ' ';
+    line += QByteArray::number(trace.seed) + ' ';
+    foreach (quint8 a, trace.actions) line += actionChars[qMin(int(a), 5)];
+    return line;
+}
+
+
+//The custom shapes have no name, and are written as squares; the tester never makes them.
+bool DifferentialTester::parseTrace(const QByteArray &line, Trace &trace){
+    QList<QByteArray> fields = line.trimmed().split(' ');
+    if (fields.size() < 7 || fields.size() > 8) return false;
+    bool ok[6];
+    trace.params.size = fields[0].toInt(&ok[0]);
+    trace.params.wallnum = fields[1].toInt(&ok[1]);
+    trace.params.enemynum = fields[2].toInt(&ok[2]);
+    trace.params.enemyspd = fields[3].toInt(&ok[3]);
+    trace.params.destroywalls = fields[4].toInt(&ok[4]) != 0;
+    trace.seed = fields[6].toUInt(&ok[5]);
+    for (int k = 0; k < 6; k++){
+        if (!ok[k]) return false;
+    }
+    if (trace.params.size < 7 || trace.params.enemyspd < 1) return false;
+
+    int shape = -1;
+    for (int k = 0; k < 3 && shape < 0; k++){
+        if (fields[5].startsWith(shapeNames[k])) shape = k;
+    }
+    if (shape < 0) return false;
+    bool radiusOk;
+    int radius = fields[5].mid(int(qstrlen(shapeNames[shape]))).toInt(&radiusOk);
+    if (!radiusOk || radius < 1) return false;
+    trace.stencil = BlastStencil(BlastStencil::Shape(shape), radius);
+
+    trace.actions.resize(0);
+    if (fields.size() == 8){
+        foreach (char c, fields[7]){
+            int a = 0;
+            while (a < 6 && actionChars[a] != c) a++;
+            if (a == 6) return false;
+            trace.actions.append(quint8(a));
+        }
+    }
+    return true;
+}
+
+
+
+//-----PRIVATE METHODS-----
+
+//The rules of a round: the ranges stay clear of boards where the walls leave no room for the enemies.
+GameModel::Params DifferentialTester::randomParams(GameRandom &random){
+    GameModel::Params p;
+    p.size = 10 + random.bounded(21);
+    p.wallnum = random.bounded(p.size * p.size / 8 + 1);
+    p.enemynum = 1 + random.bounded(p.size / 2);
+    p.enemyspd = 1 + random.bounded(8);
+    p.destroywalls = random.bounded(2) != 0;
+    return p;
+}
+
+
+BlastStencil DifferentialTester::randomStencil(GameRandom &random){
+    int shape = random.bounded(3);
+    return BlastStencil(BlastStencil::Shape(shape), 1 + random.bounded(shape == BlastStencil::Square ? 4 : 6));
+}
+
+
+//Starts the trace's game on the model, at the batch's pace, and spends the first input tick (see the class comment).
+void DifferentialTester::startModel(GameModel &model, const Trace &trace){
+    model.reset(trace.params, trace.seed);
+    model.setBlastStencil(trace.stencil);
+    model.setPlayerMoveRate(trace.params.enemyspd);
+    GameModel::TickInput stay = {false, -1};
+    model.stepInputTick(stay);
+}
+
+
+GameModel::TickInput DifferentialTester::tickInput(quint8 action){
+    GameModel::TickInput input = {false, -1};
+    switch (action){
+        case BatchEnvironment::MoveUp: input.move = GameModel::Up; break;
+        case BatchEnvironment::MoveRight: input.move = GameModel::Right; break;
+        case BatchEnvironment::MoveDown: input.move = GameModel::Down; break;
+        case BatchEnvironment::MoveLeft: input.move = GameModel::Left; break;
+        case BatchEnvironment::CallAirstrike: input.airstrike = true; break;
+        default: break;
+    }
+    return input;
+}
+
+
+//A game that ended has been restarted by the batch already, so only the ending itself is compared then.
+//The model pauses when its game ends (and is never paused otherwise here); a blast that kills the last enemy
+//ends it at the next step of the enemies, like the batch.
+DifferentialTester::Outcome DifferentialTester::compareStep(GameModel &model, GameModel::State &s, const BatchEnvironment &env, int e,
+                                                            const BatchEnvironment::StepResult &r, QString* difference){
+    bool modelEnded = model.gamePaused();
+    if (modelEnded || r.dones[e]){
+        bool same = modelEnded == bool(r.dones[e]) && (!modelEnded || model.getPlayerDied() != bool(r.wins[e]));
+        if (same) return Ended;
+        if (difference){
+            if (!r.dones[e]) *difference = QString("the model's game ended (%1), the batch's didn't").arg(model.getPlayerDied() ? "lost" : "won");
+            else if (!modelEnded) *difference = QString("the batch's game ended (%1), the model's didn't").arg(r.wins[e] ? "won" : "lost");
+            else *difference = QString("the model's game was %1, the batch's %2").arg(model.getPlayerDied() ? "lost" : "won")
+                                                                               .arg(r.wins[e] ? "won" : "lost");
+        }
+        return Differs;
+    }
+
+    model.saveState(s);
+    if (hashModel(s) == hashBatch(env, e)) return Going;
+    if (difference) *difference = describeDifference(s, env, e);
+    return Differs;
+}
+
+
+//The player's facing is left out: the batch doesn't keep it. The target only counts while there is an airstrike.
+quint64 DifferentialTester::hashModel(const GameModel::State &s){
+    StateHash h;
+    for (int k = 0; k < s.tiles.size(); k++) h.add(s.tiles[k]);
+    h.add(s.player.x);
+    h.add(s.player.y);
+    h.add(s.enemies.size());
+    for (int k = 0; k < s.enemies.size(); k++){
+        h.add(s.enemies[k].x);
+        h.add(s.enemies[k].y);
+        h.add(s.enemies[k].facing);
+    }
+    h.add(s.randomState);
+    h.add(s.gameTime);
+    h.add(s.waitingForExplosion);
+    h.add(s.explosionDelay);
+    if (s.waitingForExplosion){
+        h.add(s.target.x);
+        h.add(s.target.y);
+    }
+    return h.value();
+}
+
+
+quint64 DifferentialTester::hashBatch(const BatchEnvironment &env, int e){
+    StateHash h;
+    const quint8* t = env.tiles(e);
+    for (int k = 0; k < env.size() * env.size(); k++) h.add(t[k]);
+    h.add(env.playerX(e));
+    h.add(env.playerY(e));
+    h.add(env.enemyCount(e));
+    for (int k = 0; k < env.enemyCount(e); k++){
+        h.add(env.enemyX(e, k));
+        h.add(env.enemyY(e, k));
+        h.add(env.enemyFacing(e, k));
+    }
+    h.add(env.randomState(e));
+    h.add(env.gameTime(e));
+    h.add(env.airstrikePending(e));
+    h.add(env.countdown(e));
+    if (env.airstrikePending(e)){
+        h.add(env.targetX(e));
+        h.add(env.targetY(e));
+    }
+    return h.value();
+}
+
+
+//the first part of the states that differs, in the order of the hashes
+QString DifferentialTester::describeDifference(const GameModel::State &s, const BatchEnvironment &env, int e){
+    int n = env.size();
+    const quint8* t = env.tiles(e);
+    for (int k = 0; k < n * n; k++){
+        if (s.tiles[k] != t[k]) return QString("tile (%1,%2): model %3, batch %4").arg(k / n).arg(k % n).arg(int(s.tiles[k])).arg(int(t[k]));
+    }
+    if (s.player.x != env.playerX(e) || s.player.y != env.playerY(e)){
+        return QString("player: model (%1,%2), batch (%3,%4)").arg(s.player.x).arg(s.player.y).arg(env.playerX(e)).arg(env.playerY(e));
+    }
+    if (s.enemies.size() != env.enemyCount(e)){
+        return QString("enemies: model %1, batch %2").arg(s.enemies.size()).arg(env.enemyCount(e));
+    }
+    for (int k = 0; k < s.enemies.size(); k++){
+        const GameModel::Position &m = s.enemies[k];
+        if (m.x != env.enemyX(e, k) || m.y != env.enemyY(e, k) || int(m.facing) != env.enemyFacing(e, k)){
+            return QString("enemy %1: model (%2,%3) facing %4, batch (%5,%6) facing %7").arg(k).arg(m.x).arg(m.y).arg(int(m.facing))
+                   .arg(env.enemyX(e, k)).arg(env.enemyY(e, k)).arg(env.enemyFacing(e, k));
+        }
+    }
+    if (s.randomState != env.randomState(e)) return QString("the random sequences differ");
+    if (s.gameTime != env.gameTime(e)) return QString("time: model %1, batch %2").arg(s.gameTime).arg(env.gameTime(e));
+    if (s.waitingForExplosion != env.airstrikePending(e) || s.explosionDelay != env.countdown(e)){
+        return QString("airstrike: model %1 (countdown %2), batch %3 (countdown %4)").arg(int(s.waitingForExplosion)).arg(s.explosionDelay)
+               .arg(int(env.airstrikePending(e))).arg(env.countdown(e));
+    }
+    return QString("target: model (%1,%2), batch (%3,%4)").arg(s.target.x).arg(s.target.y).arg(env.targetX(e)).arg(env.targetY(e));
+}
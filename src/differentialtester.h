@@ -0,0 +1,105 @@
+#ifndef DIFFERENTIALTESTER_H
+#define DIFFERENTIALTESTER_H
+
+#include <QVector>
+#include <QByteArray>
+#include <QString>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
+#include "gamemodel.h"
+#include "batchenvironment.h"
+
+//Checks that a fast engine plays exactly like GameModel: the model (the reference) and a BatchEnvironment (the
+//candidate, which the tuner, the estimator and the benchmarks build on) play the same games side by side, from the
+//same seeds and with the same random actions, and their states are hashed and compared after every step.
+//
+//The two are kept in lockstep by running the model at the batch's pace: the player moves as often as the enemies
+//step, and each step is one input tick of the model (GameModel::stepInputTick), which runs the enemies' step and the
+//second that are due after the input, like BatchEnvironment::step. The model's very first input tick comes before
+//any enemy step, so it is spent standing still.
+//
+//The games are played in rounds, a set of rules per round (the size, walls, enemies, speed, wall rule and the shape
+//of the blast are random), by one worker per core. The first step at which a game differs is kept, and the actions
+//leading to it are cut down to a minimal trace: one where no single action can be left out, or turned into standing
+//still, without the two playing the same. A trace is written as one line, which parseTrace() and the bomberdiff tool
+//take back:
+//  size walls enemies speed destroywalls blast seed actions
+//e.g. "10 0 1 3 1 square3 7 ..RRDA..", where the blast is the shape and radius of a BlastStencil and the actions
+//are '.' (stay), 'U' 'R' 'D' 'L' (moves) and 'A' (airstrike), one per step.
+class DifferentialTester
+{
+public:
+    struct Settings{
+        qint64 games = 10000;
+        int maxSteps = 400;          //a game still going after this many steps is left there
+        int gamesPerRound = 32;      //played at once by a worker, on the same rules
+        int threads = 0;             //0: every core
+        int maxDivergences = 8;      //the workers stop after finding this many
+        double airstrikeRate = 0.05; //of the random actions; the rest are moves and standing still
+    };
+
+    //a game, from its start
+    struct Trace{
+        GameModel::Params params;
+        BlastStencil stencil;
+        quint32 seed;
+        QVector<quint8> actions;     //BatchEnvironment::Action, one per step
+    };
+
+    struct Divergence{
+        Trace trace;                 //minimized
+        int step;                    //the last action of the trace, after which the states differ
+        QString difference;          //what differs first, in words
+    };
+
+    struct Report{
+        qint64 games;
+        qint64 steps;
+        QVector<Divergence> divergences;
+    };
+
+    explicit DifferentialTester(const Settings &settings);
+
+    //plays the games of the settings; the rules and actions of the rounds come from 'seed'
+    Report run(quint32 seed);
+
+    //plays the trace on both engines; returns the step after which they first differ, or -1 if they never do
+    static int replay(const Trace &trace, QString* difference = 0);
+    //the shortest trace found (by leaving out actions, and turning them into standing still) that still differs
+    static Trace minimize(const Trace &trace);
+
+    static QByteArray formatTrace(const Trace &trace);
+    static bool parseTrace(const QByteArray &line, Trace &trace);
+
+private:
+    class Worker : public QRunnable
+    {
+    public:
+        DifferentialTester* owner;
+        int first;                   //the first round of this worker; it takes every 'workers'-th one after it
+        int workers;
+        qint64 games;
+        qint64 steps;
+        QVector<Divergence> found;
+        void run();
+    };
+
+    enum Outcome { Going, Ended, Differs };
+
+    Settings _settings;
+    quint32 _seed;
+    QAtomicInt divergences;          //found by all workers so far
+
+    static GameModel::Params randomParams(GameRandom &random);
+    static BlastStencil randomStencil(GameRandom &random);
+    static void startModel(GameModel &model, const Trace &trace);
+    static GameModel::TickInput tickInput(quint8 action);
+    static Outcome compareStep(GameModel &model, GameModel::State &s, const BatchEnvironment &env, int e,
+                               const BatchEnvironment::StepResult &r, QString* difference);
+    static quint64 hashModel(const GameModel::State &s);
+    static quint64 hashBatch(const BatchEnvironment &env, int e);
+    static QString describeDifference(const GameModel::State &s, const BatchEnvironment &env, int e);
+};
+
+#endif // DIFFERENTIALTESTER_H
@@ -0,0 +1,102 @@
+#include "difficultytuner.h"
+#include "batchenvironment.h"
+#include "referencebot.h"
+#include <QtMath>
+
+WinRateTest::WinRateTest(double low, double high, double alpha, double beta):
+    winStep(qLn(high / low)), lossStep(qLn((1 - high) / (1 - low))),
+    lower(qLn(beta / (1 - alpha))), upper(qLn((1 - beta) / alpha)),
+    llr(0), n(0), w(0), decided(Undecided)
+{
+}
+
+
+//Once decided, the decision doesn't change.
+WinRateTest::Decision WinRateTest::add(bool won){
+    if (decided != Undecided) return decided;
+    n++;
+    if (won) w++;
+    llr += won ? winStep : lossStep;
+    if (llr >= upper) decided = High;
+    else if (llr <= lower) decided = Low;
+    return decided;
+}
+
+
+
+DifficultyTuner::DifficultyTuner(const Settings &settings):
+    _settings(settings), games(0), steps(0)
+{
+    _settings.margin = qBound(0.001, _settings.margin, qMin(_settings.targetWinRate, 1 - _settings.targetWinRate) - 0.001);
+}
+
+
+//Plays the configuration until the test decides. The seeds of the games come from 'seed', so an evaluation can be repeated.
+DifficultyTuner::Result DifficultyTuner::evaluate(const GameModel::Params &params, quint32 seed){
+    const Settings &s = _settings;
+    BatchEnvironment env(s.parallelGames, params, s.threads);
+    quint32 nextSeed = seed;
+    QVector<quint32> first(s.parallelGames);
+    for (int e = 0; e < first.size(); e++) first[e] = nextSeed++;
+    env.reset(first.constData());
+    ReferenceBot bot(seed);
+
+    WinRateTest test(s.targetWinRate - s.margin, s.targetWinRate + s.margin, s.alpha, s.beta);
+    QVector<quint8> actions(s.parallelGames);
+    QVector<int> length(s.parallelGames, 0);
+    while (test.decision() == WinRateTest::Undecided && test.games() < s.maxGames){
+        bot.actAll(env, actions.data());
+        BatchEnvironment::StepResult r = env.step(actions.constData());
+        for (int e = 0; e < s.parallelGames && test.decision() == WinRateTest::Undecided && test.games() < s.maxGames; e++){
+            if (r.dones[e]){
+                test.add(r.wins[e]);
+                length[e] = 0;
+            } else if (++length[e] >= s.maxSteps){
+                test.add(false);
+                length[e] = 0;
+                env.restartGame(e, nextSeed++);
+            }
+        }
+    }
+    games += test.games();
+    steps += env.totalSteps();
+
+    Result result;
+    result.params = params;
+    result.verdict = test.decision() == WinRateTest::High ? TooEasy : test.decision() == WinRateTest::Low ? TooHard : OnTarget;
+    result.games = test.games();
+    result.wins = test.wins();
+    return result;
+}
+
+
+//Bisects the number of enemies between 1 and the size of the board (the range of the View).
+DifficultyTuner::Result DifficultyTuner::tuneEnemies(GameModel::Params params, quint32 seed){
+    int low = 1, high = params.size;
+    Result closest;
+    closest.verdict = TooEasy;
+    closest.games = 0;
+    while (low <= high){
+        params.enemynum = (low + high) / 2;
+        Result r = evaluate(params, seed);
+        closest = r;
+        if (r.verdict == OnTarget) break;
+        if (r.verdict == TooEasy) low = params.enemynum + 1;
+        else high = params.enemynum - 1;
+    }
+    return closest;
+}
+
+
+QVector<DifficultyTuner::Result> DifficultyTuner::sweep(const QVector<int> &sizes, const QVector<int> &speeds, quint32 seed){
+    QVector<Result> results;
+    foreach (int size, sizes){
+        foreach (int speed, speeds){
+            for (int quarters = 0; quarters <= 2; quarters++){
+                GameModel::Params params = {size, maxWalls(size) * quarters / 4, 1, speed, true};
+                results.append(tuneEnemies(params, seed++));
+            }
+        }
+    }
+    return results;
+}
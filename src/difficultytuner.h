@@ -0,0 +1,86 @@
+#ifndef DIFFICULTYTUNER_H
+#define DIFFICULTYTUNER_H
+
+#include <QVector>
+#include "gamemodel.h"
+
+//Wald's sequential probability ratio test of a win rate: is it (at most) 'low', or (at least) 'high'?
+//The games are added one by one, and the test decides as soon as the evidence is strong enough for the error
+//rates 'alpha' (deciding high when it is low) and 'beta' (deciding low when it is high). A win rate far from both
+//is decided after a few games; one between them might take many, or never be decided.
+class WinRateTest
+{
+public:
+    enum Decision { Undecided, Low, High };
+
+    WinRateTest(double low, double high, double alpha, double beta);
+    Decision add(bool won);
+
+    Decision decision() const {return decided;}
+    int games() const {return n;}
+    int wins() const {return w;}
+    double logLikelihoodRatio() const {return llr;}
+
+private:
+    double winStep, lossStep; //what a win and a loss add to the log likelihood ratio
+    double lower, upper;      //the ratio at which it is decided
+    double llr;
+    int n, w;
+    Decision decided;
+};
+
+
+//Searches the settings of the game for the ones where the ReferenceBot wins at a target rate, to set the ranges
+//of the sliders (see GameView) by measurement instead of by hand.
+//A configuration is evaluated by playing it in a BatchEnvironment (many games at once, on every core) and
+//feeding the finished games to a WinRateTest of the target plus and minus the margin, until it decides or
+//maxGames games are played: most configurations are far from the target, and are settled after a few dozen games.
+//For a given size, speed and wall count, the number of enemies is found by bisection (more enemies is harder).
+//
+//The games still running when a test decides are thrown away, which favours the short games a little;
+//keep 'parallelGames' well below the games a decision takes.
+class DifficultyTuner
+{
+public:
+    struct Settings{
+        double targetWinRate = 0.5;
+        double margin = 0.1;
+        double alpha = 0.05;
+        double beta = 0.05;
+        int maxGames = 2000;    //a configuration still undecided after this many games is on target
+        int maxSteps = 3000;    //a game that takes longer than this is lost (the bot is stuck)
+        int parallelGames = 64;
+        int threads = 0;        //0: every core
+    };
+
+    enum Verdict { TooEasy, TooHard, OnTarget };
+
+    struct Result{
+        GameModel::Params params;
+        Verdict verdict;
+        int games;
+        int wins;
+    };
+
+    explicit DifficultyTuner(const Settings &settings);
+
+    Result evaluate(const GameModel::Params &params, quint32 seed);
+    //the number of enemies (params.enemynum is ignored) that is on target, or the closest one tried
+    Result tuneEnemies(GameModel::Params params, quint32 seed);
+    //tunes the enemies for every size and speed, with no walls, and with a quarter and half of the most walls allowed
+    QVector<Result> sweep(const QVector<int> &sizes, const QVector<int> &speeds, quint32 seed);
+
+    const Settings& settings() const {return _settings;}
+    qint64 totalGames() const {return games;}
+    qint64 totalSteps() const {return steps;}
+
+    //the most walls the View allows on a board of this size
+    static int maxWalls(int size) {return size * size / 4 + size;}
+
+private:
+    Settings _settings;
+    qint64 games;
+    qint64 steps;
+};
+
+#endif // DIFFICULTYTUNER_H
@@ -0,0 +1,296 @@
+#include "framecodec.h"
+
+enum MessageType { Keyframe = 'K', Delta = 'D' };
+enum StatusFlag { AirstrikeFlag = 1, PausedFlag = 2, EndedFlag = 4, PlayerWonFlag = 8 };
+//how the enemies of a delta are given
+enum EnemyMode { RelativeEnemies, AbsoluteEnemies };
+
+
+//-----ENCODER-----
+
+FrameEncoder::FrameEncoder():
+    currentTick(0), size(0), keyframeReady(false)
+{
+    body.reserve(4096);
+    deltaMessage.reserve(4096);
+    keyframeMessage.reserve(4096);
+}
+
+
+//The previous state is kept for the next delta, in buffers that are swapped instead of reallocated.
+//The first tick (and the first tick after the size of the board changed) can't be a delta: its "delta" is a keyframe.
+void FrameEncoder::encode(const QVector< QVector<GameModel::TileType> > &table, const GameModel::Position &p,
+                          const QVector<GameModel::Position> &e, const FrameStatus &s){
+    int n = table.size();
+    bool sizeChanged = n != size;
+    tiles.swap(previousTiles);
+    tiles.resize(n * n);
+    for (int i = 0; i < n; ++i){
+        const GameModel::TileType* row = table[i].constData();
+        for (int j = 0; j < n; ++j) tiles[i*n + j] = quint8(row[j]);
+    }
+    previousPlayer = player;
+    player = p;
+    enemies.swap(previousEnemies);
+    enemies.resize(e.size());
+    for (int k = 0; k < e.size(); k++) enemies[k] = e[k];
+    status = s;
+    size = n;
+    currentTick++;
+    keyframeReady = false;
+
+    if (sizeChanged){
+        deltaMessage = keyframe();
+        return;
+    }
+
+    body.resize(0);
+    body.append(char(Delta));
+    appendVarint(body, currentTick);
+    //the changed tiles, as runs of the same new tile
+    int cells = n * n;
+    int lastEnd = 0;
+    for (int i = 0; i < cells; ){
+        if (tiles[i] == previousTiles[i]) {
+            i++;
+            continue;
+        }
+        int j = i + 1;
+        while (j < cells && tiles[j] != previousTiles[j] && tiles[j] == tiles[i]) j++;
+        appendVarint(body, i - lastEnd);
+        appendVarint(body, j - i);
+        body.append(char(tiles[i]));
+        lastEnd = j;
+        i = j;
+    }
+    appendVarint(body, 0);
+    appendVarint(body, 0); //a run of length 0 ends the list
+
+    appendStatus(body);
+    appendVarint(body, zigzag(player.x - previousPlayer.x) << 2 | player.facing);
+    appendVarint(body, zigzag(player.y - previousPlayer.y));
+    appendVarint(body, enemies.size());
+    if (enemies.size() == previousEnemies.size()){
+        body.append(char(RelativeEnemies));
+        for (int k = 0; k < enemies.size(); k++){
+            appendVarint(body, zigzag(enemies[k].x - previousEnemies[k].x) << 2 | enemies[k].facing);
+            appendVarint(body, zigzag(enemies[k].y - previousEnemies[k].y));
+        }
+    } else {
+        //an enemy died: the indices have changed, so the positions are sent as they are
+        body.append(char(AbsoluteEnemies));
+        for (int k = 0; k < enemies.size(); k++){
+            appendVarint(body, enemies[k].x);
+            appendVarint(body, enemies[k].y);
+            body.append(char(enemies[k].facing));
+        }
+    }
+    finish(deltaMessage);
+}
+
+
+const QByteArray& FrameEncoder::keyframe(){
+    if (!keyframeReady){
+        encodeKeyframe(keyframeMessage);
+        keyframeReady = true;
+    }
+    return keyframeMessage;
+}
+
+
+void FrameEncoder::encodeKeyframe(QByteArray &out){
+    body.resize(0);
+    body.append(char(Keyframe));
+    appendVarint(body, currentTick);
+    appendVarint(body, size);
+    int cells = size * size;
+    for (int i = 0; i < cells; ){
+        int j = i + 1;
+        while (j < cells && tiles[j] == tiles[i]) j++;
+        appendVarint(body, j - i);
+        body.append(char(tiles[i]));
+        i = j;
+    }
+    appendStatus(body);
+    appendVarint(body, player.x);
+    appendVarint(body, player.y);
+    body.append(char(player.facing));
+    appendVarint(body, enemies.size());
+    for (int k = 0; k < enemies.size(); k++){
+        appendVarint(body, enemies[k].x);
+        appendVarint(body, enemies[k].y);
+        body.append(char(enemies[k].facing));
+    }
+    finish(out);
+}
+
+
+void FrameEncoder::appendStatus(QByteArray &out){
+    appendVarint(out, status.bombedEnemies);
+    appendVarint(out, status.gameTime);
+    appendVarint(out, status.countdown);
+    out.append(char((status.airstrike ? AirstrikeFlag : 0) | (status.paused ? PausedFlag : 0) |
+                    (status.ended ? EndedFlag : 0) | (status.playerWon ? PlayerWonFlag : 0)));
+}
+
+
+//puts the length in front of the body
+void FrameEncoder::finish(QByteArray &message){
+    message.resize(0);
+    appendVarint(message, body.size());
+    message.append(body);
+}
+
+
+
+//-----DECODER-----
+
+FrameDecoder::FrameDecoder():
+    currentTick(0), synced(false), dropped(0)
+{
+    current.player.x = 0;
+    current.player.y = 0;
+    current.player.facing = GameModel::Right;
+    current.bombedEnemies = 0;
+    current.gameTime = 0;
+    current.airstrike = false;
+    current.countdown = 0;
+    current.target = current.player;
+    current.statusUpdates = 0;
+    current.paused = false;
+    current.ended = false;
+    current.playerWon = false;
+}
+
+
+//Splits the stream into messages; an incomplete message at the end is kept until the rest arrives.
+int FrameDecoder::feed(const char* data, int length){
+    pending.append(data, length);
+    const char* p = pending.constData();
+    const char* end = p + pending.size();
+    int frames = 0;
+    while (p < end){
+        const char* q = p;
+        quint64 bodyLength;
+        if (!readVarint(q, end, bodyLength) || quint64(end - q) < bodyLength) break;
+        if (decodeMessage(q, q + bodyLength)) frames++;
+        p = q + bodyLength;
+    }
+    pending.remove(0, int(p - pending.constData()));
+    return frames;
+}
+
+
+//Applies one message to the current frame. A delta that doesn't follow the current tick is dropped,
+//and so is everything after it, until the next keyframe.
+bool FrameDecoder::decodeMessage(const char* p, const char* end){
+    if (p >= end) return false;
+    char type = *p++;
+    quint64 tick;
+    if (!readVarint(p, end, tick) || (type != Keyframe && type != Delta)) {
+        dropped++;
+        return false;
+    }
+    if (type == Delta && (!synced || quint32(tick) != currentTick + 1)){
+        synced = false;
+        dropped++;
+        return false;
+    }
+
+    quint64 a, b;
+    bool ok = true;
+    int n = current.table.size();
+    if (type == Keyframe){
+        ok = readVarint(p, end, a) && a > 0 && a <= 1024;
+        if (ok){
+            n = int(a);
+            current.table.resize(n);
+            for (int i = 0; i < n; ++i) current.table[i].resize(n);
+        }
+        for (int cell = 0; ok && cell < n * n; ){
+            ok = readVarint(p, end, a) && p < end && a > 0 && a <= quint64(n * n - cell);
+            if (!ok) break;
+            GameModel::TileType t = GameModel::TileType(quint8(*p++));
+            for (quint64 k = 0; k < a; k++, cell++) current.table[cell / n][cell % n] = t;
+        }
+    } else {
+        int cell = 0;
+        while (ok){
+            ok = readVarint(p, end, a) && readVarint(p, end, b);
+            if (!ok || b == 0) break;
+            cell += int(a);
+            ok = p < end && cell + b <= quint64(n * n);
+            if (!ok) break;
+            GameModel::TileType t = GameModel::TileType(quint8(*p++));
+            for (quint64 k = 0; k < b; k++, cell++) current.table[cell / n][cell % n] = t;
+        }
+    }
+
+    ok = ok && readStatus(p, end);
+    if (ok && type == Keyframe){
+        ok = readVarint(p, end, a) && readVarint(p, end, b) && p < end;
+        if (ok){
+            current.player.x = int(a);
+            current.player.y = int(b);
+            current.player.facing = GameModel::Direction(*p++ & 3);
+        }
+    } else if (ok){
+        ok = readVarint(p, end, a) && readVarint(p, end, b);
+        if (ok){
+            current.player.x += int(unzigzag(a >> 2));
+            current.player.facing = GameModel::Direction(a & 3);
+            current.player.y += int(unzigzag(b));
+        }
+    }
+
+    quint64 count = 0;
+    ok = ok && readVarint(p, end, count) && count <= 4096;
+    char mode = AbsoluteEnemies;
+    if (ok && type == Delta){
+        ok = p < end;
+        if (ok) mode = *p++;
+        ok = ok && (mode == AbsoluteEnemies || int(count) == current.enemies.size());
+    }
+    if (ok) current.enemies.resize(int(count));
+    for (int k = 0; ok && k < int(count); k++){
+        GameModel::Position &e = current.enemies[k];
+        ok = readVarint(p, end, a) && readVarint(p, end, b);
+        if (!ok) break;
+        if (mode == AbsoluteEnemies){
+            ok = p < end;
+            if (!ok) break;
+            e.x = int(a);
+            e.y = int(b);
+            e.facing = GameModel::Direction(*p++ & 3);
+        } else {
+            e.x += int(unzigzag(a >> 2));
+            e.facing = GameModel::Direction(a & 3);
+            e.y += int(unzigzag(b));
+        }
+    }
+
+    if (!ok){
+        synced = false;
+        dropped++;
+        return false;
+    }
+    synced = true;
+    currentTick = quint32(tick);
+    current.statusUpdates++;
+    return true;
+}
+
+
+bool FrameDecoder::readStatus(const char* &p, const char* end){
+    quint64 bombed, time, countdown;
+    if (!readVarint(p, end, bombed) || !readVarint(p, end, time) || !readVarint(p, end, countdown) || p >= end) return false;
+    quint8 flags = quint8(*p++);
+    current.bombedEnemies = int(bombed);
+    current.gameTime = int(time);
+    current.countdown = int(countdown);
+    current.airstrike = flags & AirstrikeFlag;
+    current.paused = flags & PausedFlag;
+    current.ended = flags & EndedFlag;
+    current.playerWon = flags & PlayerWonFlag;
+    return true;
+}
@@ -0,0 +1,112 @@
+#ifndef FRAMECODEC_H
+#define FRAMECODEC_H
+
+#include <QByteArray>
+#include <QVector>
+#include "gamemodel.h"
+
+//The wire format of the spectator stream (see SpectatorPublisher).
+//
+//Every message is a varint length followed by the body. A body begins with its type ('K' or 'D') and the
+//varint number of its tick. A keyframe ('K') holds the whole state: the size of the board, the tiles as runs
+//of equal tiles (varint length, tile), then the status, the player and the enemies at absolute positions.
+//A delta ('D') only holds what changed since the previous tick: the changed tiles as runs (varint gap since the
+//previous run, varint length, the new tile of the whole run), the status, and the moves of the player and the
+//enemies as small zigzag varints. A delta can only be applied right after the tick before it; a viewer that
+//missed one waits for the next keyframe.
+//Varints are unsigned LEB128 (7 bits per byte); signed numbers are zigzag encoded first.
+
+inline void appendVarint(QByteArray &out, quint64 v){
+    while (v >= 0x80){
+        out.append(char(v | 0x80));
+        v >>= 7;
+    }
+    out.append(char(v));
+}
+
+//returns false if the data ends in the middle of the number
+inline bool readVarint(const char* &p, const char* end, quint64 &v){
+    v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7){
+        quint8 b = quint8(*p++);
+        v |= quint64(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+inline quint64 zigzag(qint64 v) {return (quint64(v) << 1) ^ quint64(v >> 63);}
+inline qint64 unzigzag(quint64 v) {return qint64(v >> 1) ^ -qint64(v & 1);}
+
+
+//the panel of the View: everything of a frame besides the board and the entities
+struct FrameStatus{
+    int bombedEnemies;
+    int gameTime;
+    bool airstrike;
+    int countdown;
+    bool paused;
+    bool ended;
+    bool playerWon;
+};
+
+
+//Encodes the states of a game, tick after tick. The keyframe and the delta of the same tick describe the same
+//state, so every viewer can be sent whichever it needs. The buffers are reused between ticks.
+class FrameEncoder
+{
+public:
+    FrameEncoder();
+
+    //takes the state of the next tick (only read during the call) and encodes its delta
+    void encode(const QVector< QVector<GameModel::TileType> > &table, const GameModel::Position &player,
+                const QVector<GameModel::Position> &enemies, const FrameStatus &status);
+    //the messages of the last encoded tick; the keyframe is only built when someone asks for it
+    const QByteArray& delta() const {return deltaMessage;}
+    const QByteArray& keyframe();
+    quint32 tick() const {return currentTick;}
+
+private:
+    quint32 currentTick;
+    int size;
+    bool keyframeReady;
+    QVector<quint8> tiles, previousTiles;
+    GameModel::Position player, previousPlayer;
+    QVector<GameModel::Position> enemies, previousEnemies;
+    FrameStatus status;
+    QByteArray body;
+    QByteArray deltaMessage;
+    QByteArray keyframeMessage;
+
+    void encodeKeyframe(QByteArray &out);
+    void appendStatus(QByteArray &out);
+    void finish(QByteArray &message);
+};
+
+
+//Rebuilds the frames of a game from the stream of an encoder.
+class FrameDecoder
+{
+public:
+    FrameDecoder();
+
+    //feeds the next bytes of the stream; returns the number of frames completed by them
+    int feed(const char* data, int length);
+    //the last completed frame
+    const GameModel::Frame& frame() const {return current;}
+    quint32 tick() const {return currentTick;}
+    bool synchronized() const {return synced;}
+    int droppedMessages() const {return dropped;}
+
+private:
+    GameModel::Frame current;
+    quint32 currentTick;
+    bool synced;
+    int dropped;
+    QByteArray pending;
+
+    bool decodeMessage(const char* p, const char* end);
+    bool readStatus(const char* &p, const char* end);
+};
+
+#endif // FRAMECODEC_H
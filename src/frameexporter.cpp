@@ -0,0 +1,92 @@
+#include "frameexporter.h"
+#include <QFile>
+#include <QDir>
+#include <QtAlgorithms>
+
+FrameExporter::FrameExporter(const QString &directory, Format format, int tileSize, int threads):
+    dir(directory), fmt(format), rasterizer(tileSize), pending(0), written(0), failed(0)
+{
+    if (threads > 0) pool.setMaxThreadCount(threads);
+    QDir().mkpath(dir);
+}
+
+FrameExporter::~FrameExporter(){
+    waitForDone();
+    qDeleteAll(spareImages);
+    qDeleteAll(spareJobs);
+}
+
+
+//Renders the frame right away (so the model may go on as soon as this returns), and queues it for an encoder.
+void FrameExporter::exportFrame(int index, const QVector<QVector<GameModel::TileType> > &tiles, const GameModel::Position &p, const QVector<GameModel::Position> &e){
+    RgbImage* image;
+    EncodeJob* job;
+    {
+        QMutexLocker lock(&mutex);
+        while (pending >= maxPending) jobFinished.wait(&mutex);
+        pending++;
+        image = spareImages.isEmpty() ? new RgbImage() : spareImages.takeLast();
+        job = spareJobs.isEmpty() ? new EncodeJob() : spareJobs.takeLast();
+    }
+    rasterizer.render(tiles, p, e, *image);
+    job->owner = this;
+    job->image = image;
+    job->index = index;
+    job->setAutoDelete(false);
+    pool.start(job);
+}
+
+
+void FrameExporter::exportFrame(int index, const GameModel &model){
+    exportFrame(index, model.tableRef(), model.getPlayer(), model.enemiesRef());
+}
+
+
+bool FrameExporter::waitForDone(){
+    pool.waitForDone();
+    QMutexLocker lock(&mutex);
+    return failed == 0;
+}
+
+
+int FrameExporter::writtenFrames(){
+    QMutexLocker lock(&mutex);
+    return written;
+}
+
+
+QString FrameExporter::fileName(int index) const{
+    return dir + QString("/frame_%1.").arg(index, 6, 10, QChar('0')) + (fmt == Png ? "png" : "ppm");
+}
+
+
+//The binary form of PPM (P6): a short text header, then the pixels as they are in memory.
+QByteArray FrameExporter::ppmHeader(const RgbImage &image){
+    QByteArray header("P6\n");
+    header.append(QByteArray::number(image.width)).append(' ').append(QByteArray::number(image.height)).append("\n255\n");
+    return header;
+}
+
+
+//Runs on the encoder threads: writes the image, then gives it (and the job) back for the next frame.
+void FrameExporter::encode(EncodeJob* job){
+    bool ok;
+    const RgbImage &image = *job->image;
+    if (fmt == Png){
+        QImage view(image.pixels.constData(), image.width, image.height, image.width * 3, QImage::Format_RGB888);
+        ok = view.save(fileName(job->index), "PNG");
+    } else {
+        QFile file(fileName(job->index));
+        QByteArray header = ppmHeader(image);
+        ok = file.open(QIODevice::WriteOnly) && file.write(header) == header.size() &&
+             file.write(reinterpret_cast<const char*>(image.pixels.constData()), image.pixels.size()) == image.pixels.size();
+    }
+
+    QMutexLocker lock(&mutex);
+    if (ok) written++;
+    else failed++;
+    spareImages.push_back(job->image);
+    spareJobs.push_back(job);
+    pending--;
+    jobFinished.wakeOne();
+}
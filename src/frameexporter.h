@@ -0,0 +1,62 @@
+#ifndef FRAMEEXPORTER_H
+#define FRAMEEXPORTER_H
+
+#include <QThreadPool>
+#include <QRunnable>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QString>
+#include "framerasterizer.h"
+
+//Writes frames of a game into a directory as a numbered image sequence (frame_000000.ppm, ...), for bug reports
+//and for looking at batches of games, without the GUI.
+//A frame is rendered on the caller's thread (see FrameRasterizer), which is fast; the encoding and the writing,
+//which are not (a PNG especially), are done by a pool of threads, so the simulation goes on in the meantime.
+//At most maxPending frames wait for their encoder: past that, exportFrame() waits for one to finish.
+//The images (and their storage) are reused from frame to frame.
+class FrameExporter
+{
+public:
+    enum Format { Ppm, Png };
+    static const int maxPending = 64;
+
+    //'threads' is the number of encoder threads (0: one per core)
+    FrameExporter(const QString &directory, Format format, int tileSize = 16, int threads = 0);
+    ~FrameExporter();
+
+    void exportFrame(int index, const QVector<QVector<GameModel::TileType> > &tiles, const GameModel::Position &p, const QVector<GameModel::Position> &e);
+    void exportFrame(int index, const GameModel &model);
+    //waits until every frame is written; returns false if any of them couldn't be
+    bool waitForDone();
+    int writtenFrames();
+    QString fileName(int index) const;
+
+    static QByteArray ppmHeader(const RgbImage &image);
+
+private:
+    class EncodeJob : public QRunnable
+    {
+    public:
+        FrameExporter* owner;
+        RgbImage* image;
+        int index;
+        void run() {owner->encode(this);}
+    };
+
+    QString dir;
+    Format fmt;
+    FrameRasterizer rasterizer;
+    QThreadPool pool;
+    //the members below are guarded by 'mutex'
+    QMutex mutex;
+    QWaitCondition jobFinished;
+    int pending;
+    int written;
+    int failed;
+    QVector<RgbImage*> spareImages;
+    QVector<EncodeJob*> spareJobs;
+
+    void encode(EncodeJob* job);
+};
+
+#endif // FRAMEEXPORTER_H
@@ -0,0 +1,98 @@
+#include "framerasterizer.h"
+
+//the colors of the board in the GUI
+static const QRgb floorColor = qRgb(249, 255, 175);
+static const QRgb wallColor = qRgb(139, 139, 139);
+static const QRgb playerColor = qRgb(0, 70, 197);
+static const QRgb enemyColor = qRgb(193, 0, 0);
+static const QRgb gridColor = qRgb(160, 160, 164);
+
+
+FrameRasterizer::FrameRasterizer(int tileSize):
+    ts(qMax(1, tileSize))
+{
+    crosshair = loadSprite(":/crosshair.png", ts);
+    explosion = loadSprite(":/explosion.png", ts);
+}
+
+
+QVector<QRgb> FrameRasterizer::loadSprite(const QString &fileName, int size){
+    QVector<QRgb> sprite;
+    QImage image(fileName);
+    if (image.isNull()) return sprite;
+    image = image.convertToFormat(QImage::Format_ARGB32).scaled(size, size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    sprite.resize(size * size);
+    for (int i = 0; i < size; ++i){
+        for (int j = 0; j < size; ++j) sprite[i * size + j] = image.pixel(j, i);
+    }
+    return sprite;
+}
+
+
+//The image is tileSize pixels for each tile; its storage is reused if it is already that big.
+void FrameRasterizer::render(const QVector<QVector<GameModel::TileType> > &tiles, const GameModel::Position &p, const QVector<GameModel::Position> &e, RgbImage &out) const{
+    int n = tiles.size();
+    out.width = n * ts;
+    out.height = n * ts;
+    out.pixels.resize(out.width * out.height * 3);
+
+    for (int i = 0; i < n; ++i){
+        for (int j = 0; j < n; ++j){
+            GameModel::TileType t = tiles[i][j];
+            QRgb color = t == GameModel::Wall || t == GameModel::WallUnderExplosion ? wallColor : floorColor;
+            if (i == p.x && j == p.y) color = playerColor;
+            fillTile(out, i, j, color);
+            if (t == GameModel::TargetFloor) drawSprite(out, i, j, crosshair);
+            else if (t == GameModel::FloorUnderExplosion || t == GameModel::WallUnderExplosion) drawSprite(out, i, j, explosion);
+            drawBorder(out, i, j, gridColor);
+        }
+    }
+    for (int k = 0; k < e.size(); k++){
+        fillTile(out, e[k].x, e[k].y, enemyColor);
+        drawBorder(out, e[k].x, e[k].y, gridColor);
+    }
+}
+
+
+void FrameRasterizer::fillTile(RgbImage &out, int x, int y, QRgb color) const{
+    for (int i = 0; i < ts; ++i){
+        uchar* d = out.pixels.data() + ((x * ts + i) * out.width + y * ts) * 3;
+        for (int j = 0; j < ts; ++j){
+            *d++ = uchar(qRed(color));
+            *d++ = uchar(qGreen(color));
+            *d++ = uchar(qBlue(color));
+        }
+    }
+}
+
+
+//blends the sprite over the tile by its alpha
+void FrameRasterizer::drawSprite(RgbImage &out, int x, int y, const QVector<QRgb> &sprite) const{
+    if (sprite.isEmpty()) return;
+    const QRgb* s = sprite.constData();
+    for (int i = 0; i < ts; ++i){
+        uchar* d = out.pixels.data() + ((x * ts + i) * out.width + y * ts) * 3;
+        for (int j = 0; j < ts; ++j, ++s, d += 3){
+            int a = qAlpha(*s);
+            d[0] = uchar((qRed(*s) * a + d[0] * (255 - a)) / 255);
+            d[1] = uchar((qGreen(*s) * a + d[1] * (255 - a)) / 255);
+            d[2] = uchar((qBlue(*s) * a + d[2] * (255 - a)) / 255);
+        }
+    }
+}
+
+
+//the 1 pixel border of the labels in the GUI, if the tiles are big enough for it
+void FrameRasterizer::drawBorder(RgbImage &out, int x, int y, QRgb color) const{
+    if (ts < 4) return;
+    uchar rgb[3] = {uchar(qRed(color)), uchar(qGreen(color)), uchar(qBlue(color))};
+    for (int k = 0; k < ts; ++k){
+        int edge[4][2] = {{0, k}, {ts - 1, k}, {k, 0}, {k, ts - 1}};
+        for (int s = 0; s < 4; ++s){
+            uchar* d = out.pixels.data() + ((x * ts + edge[s][0]) * out.width + y * ts + edge[s][1]) * 3;
+            d[0] = rgb[0];
+            d[1] = rgb[1];
+            d[2] = rgb[2];
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef FRAMERASTERIZER_H
+#define FRAMERASTERIZER_H
+
+#include <QVector>
+#include <QImage>
+#include "gamemodel.h"
+
+//An image in memory: 3 bytes (red, green, blue) per pixel, row after row.
+struct RgbImage{
+    int width;
+    int height;
+    QVector<uchar> pixels;
+};
+
+
+//Draws a frame of the game into an RgbImage without any widget or window, the way the board looks in the GUI
+//(see BoardWidget): the tiles, the crosshair and the explosion sprites of images.qrc, the player and the enemies.
+//The sprites are scaled and decoded once, in the constructor, so render() only touches plain memory:
+//any number of threads can render with the same rasterizer.
+class FrameRasterizer
+{
+public:
+    explicit FrameRasterizer(int tileSize = 16);
+
+    int tileSize() const {return ts;}
+    void render(const QVector<QVector<GameModel::TileType> > &tiles, const GameModel::Position &p, const QVector<GameModel::Position> &e, RgbImage &out) const;
+
+private:
+    int ts;
+    QVector<QRgb> crosshair; //ts*ts pixels, with alpha; empty if the image couldn't be loaded
+    QVector<QRgb> explosion;
+
+    static QVector<QRgb> loadSprite(const QString &fileName, int size);
+    void fillTile(RgbImage &out, int x, int y, QRgb color) const;
+    void drawSprite(RgbImage &out, int x, int y, const QVector<QRgb> &sprite) const;
+    void drawBorder(RgbImage &out, int x, int y, QRgb color) const;
+};
+
+#endif // FRAMERASTERIZER_H
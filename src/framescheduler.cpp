@@ -0,0 +1,49 @@
+#include "framescheduler.h"
+#include <QGuiApplication>
+#include <QScreen>
+
+
+//The interval of the timer is taken from the refresh rate of the primary screen (60 Hz if unknown).
+FrameScheduler::FrameScheduler(QObject *parent):
+    QObject(parent), dirty(false), polling(false), requested(0), presented(0)
+{
+    qreal refreshRate = 60;
+    QScreen* screen = QGuiApplication::primaryScreen();
+    if (screen && screen->refreshRate() > 0) refreshRate = screen->refreshRate();
+
+    timer.setTimerType(Qt::PreciseTimer);
+    timer.setInterval(qMax(1, qRound(1000 / refreshRate)));
+    connect(&timer, SIGNAL(timeout()), this, SLOT(displayRefresh()));
+}
+
+
+//Starts a new series of frames, and clears the statistics.
+void FrameScheduler::start(){
+    dirty = false;
+    requested = 0;
+    presented = 0;
+    timer.start();
+}
+
+
+void FrameScheduler::stop(){
+    timer.stop();
+}
+
+
+//Called when the model has changed; the actual repaint waits for the next display frame.
+void FrameScheduler::markDirty(int updates){
+    requested += updates;
+    if (updates > 0) dirty = true;
+}
+
+
+//Called once per display frame: asks for a repaint if anything has changed since the last one.
+void FrameScheduler::displayRefresh(){
+    if (polling) emit poll();
+    if (dirty){
+        dirty = false;
+        presented++;
+        emit frameDue();
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+
+//Limits the repaints of the game table to the refresh rate of the display.
+//The View marks the board dirty whenever the model reports a change, and the scheduler emits frameDue()
+//at most once per display frame, so any number of model changes in between are merged into one repaint.
+class FrameScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FrameScheduler(QObject *parent = 0);
+
+    void start();
+    void stop();
+    //'updates' is the number of model changes that this call stands for
+    void markDirty(int updates = 1);
+    //if polling is on, poll() is emitted every display frame, before frameDue() would be
+    void setPolling(bool on) {polling = on;}
+
+    //statistics since the last start()
+    int requestedUpdates() const {return requested;}
+    int presentedFrames() const {return presented;}
+    int coalescedUpdates() const {return requested - presented;}
+    int frameInterval() const {return timer.interval();}
+
+public slots:
+    //called by the timer once per display frame (and directly by the tests)
+    void displayRefresh();
+
+private:
+    QTimer timer;
+    bool dirty;
+    bool polling;
+    int requested;
+    int presented;
+
+signals:
+    void poll();
+    void frameDue();
+};
+
+#endif // FRAMESCHEDULER_H
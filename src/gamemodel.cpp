@@ -1,14 +1,113 @@
 #include "gamemodel.h"
+#include "inputqueue.h"
+#include "blastkernel.h"
+#include "replay.h"
+#include "tileheatmap.h"
+#include "minimap.h"
+#include "openmask.h"
 #include <QDebug>
 
+//commands that had to wait longer than this many input ticks are discarded
+static const int maxInputAge = 2;
+//a second of game time, in ns
+static const qint64 secondPeriod = 1000000000;
+//at most this many ticks are caught up on at one timeout; beyond that, the game falls behind the wall clock
+//instead of spending ever longer on catching up
+static const int maxTicksPerTimeout = 500;
+
 
 //-----PUBLIC METHODS-----
 
-//The constructor creates the table, adds walls and enemies on random positions,
-//and also starts up the timers (for enemies, explosions, and time-counting).
+//The constructor sets up the clock of the game (which schedules the enemies, the explosions, time-counting
+//and the player's input), then creates the first game with a time based seed (see reset).
 GameModel::GameModel(int size, int wallnum, int enemynum, int enemyspd, bool destroywalls):
-    _size(size), _wallnum(wallnum), _enemynum(enemynum), _enemyspd(enemyspd), _destroywalls(destroywalls)
+    player(current.player), enemies(current.enemies), enemyMap(current.enemyMap), table(current.table)
 {
+    //setting up the clock; it belongs to the model, and is only (re)configured by reset()
+    clock = new QTimer(this);
+    clock->setTimerType(Qt::PreciseTimer);
+    wallClock.start();
+    lastWallTime = 0;
+    connect(clock, SIGNAL(timeout()), this, SLOT(clockTimeout()));
+    timeScale = 1.0;
+    batching = false;
+    tableDirty = false;
+    statusDirty = false;
+    coalescedUpdates = 0;
+    replayUntil = 0;
+    resumeClock = 0;
+    resimulatedTicks = 0;
+    forcedInput = 0;
+    recorder = 0;
+    heatmap = 0;
+    minimap = 0;
+    overviewDirty = false;
+    current.overviewCells = 0;
+    nextObserverId = 1;
+    current.statusUpdates = 0;
+    current.bombedEnemies = 0;
+    current.gameTime = 0;
+    current.airstrike = false;
+    current.countdown = 0;
+    current.paused = false;
+    target.x = 0;
+    target.y = 0;
+    target.facing = Up;
+    current.target = target;
+    gameClock = 0;
+    enemyPeriod = secondPeriod / qMax(1, enemyspd);
+    //the player's commands are applied at the input ticks
+    inputQueue = new InputQueue();
+    setPlayerMoveRate(8);
+
+    Params params = {size, wallnum, enemynum, enemyspd, destroywalls};
+    reset(params, quint32(QDateTime::currentMSecsSinceEpoch()));
+}
+
+GameModel::~GameModel(){
+    delete inputQueue;
+}
+
+
+//Starts a new game on the same model: creates the table, adds walls and enemies on random positions.
+//The storage of the previous game (table rows, enemy list, clock, input queue) is reused, and only grows
+//if the new game needs more, so starting a game allocates (almost) nothing.
+//The same parameters and seed always produce the same game. The clock is stopped, see startTimers().
+void GameModel::reset(const Params &params, quint32 seed){
+    startGame(params, seed, 0);
+}
+
+
+//Starts a new game like reset(params, seed), on a board that was generated beforehand (see BoardPregenerator):
+//'prepared' is the state of a game just reset with the same size, walls, enemies and seed, saved by saveState().
+//Only the board (and where the random numbers are at) is taken from it. Returns false if it doesn't fit the parameters.
+bool GameModel::reset(const Params &params, quint32 seed, const State &prepared){
+    if (prepared.tick != 0 || prepared.tiles.size() != params.size * params.size || prepared.enemies.size() != params.enemynum) {
+        return false;
+    }
+    startGame(params, seed, &prepared);
+    return true;
+}
+
+
+//The two kinds of reset: the walls and the enemies are either generated, or copied from 'prepared'.
+void GameModel::startGame(const Params &params, quint32 seed, const State* prepared){
+    _size = params.size;
+    _wallnum = params.wallnum;
+    _enemynum = params.enemynum;
+    _enemyspd = params.enemyspd;
+    _destroywalls = params.destroywalls;
+
+    clock->stop();
+    enemyPeriod = secondPeriod / qMax(1, _enemyspd);
+    gameClock = 0;
+    nextInput = inputPeriod;
+    nextEnemyStep = enemyPeriod;
+    nextSecond = secondPeriod;
+    updateClockInterval();
+    blast = selectBlastFunctions(_destroywalls);
+    if (heatmap && heatmap->size() != _size) heatmap->resize(_size);
+
     //initialize table
     table.resize(_size);
     for (int i = 0; i < _size; ++i)
@@ -22,55 +121,195 @@ GameModel::GameModel(int size, int wallnum, int enemynum, int enemyspd, bool des
     }
 
     //TODO: check whether the incoming parameters are correct (ex.: enemynum + wallnum < size ; minSize > 3)
-    qsrand(QTime::currentTime().msec()); //needed for random walls and enemies
+    this->seed = seed;
+    random.setSeed(seed); //needed for random walls and enemies
     //initialize walls
-    createWalls(_size, _wallnum);
+    if (prepared){
+        for (int i = 1; i < _size - 1; ++i){
+            for (int j = 1; j < _size - 1; ++j) table[i][j] = TileType(prepared->tiles[i*_size + j]);
+        }
+    } else {
+        createWalls(_size, _wallnum);
+    }
+    openMask.resize(_size * _size);
+    updateOpenMask(1, _size - 2, 1, _size - 2);
+    updateMinimap(0, -1, 0, -1);
     //initialize player
     player.x = 1;
     player.y = 1;
     player.facing = Right;
     playerDied = false;
     //initialize enemies
-    createEnemies(_size, _enemynum);
+    enemies.erase(enemies.begin(), enemies.end()); //unlike clear(), this keeps the capacity
+    enemies.reserve(_enemynum);
+    enemyMap.fill(0, _size * _size);
+    if (prepared){
+        for (int k = 0; k < prepared->enemies.size(); k++){
+            enemies.push_back(prepared->enemies[k]);
+            markEnemy(prepared->enemies[k]);
+        }
+        //the random numbers go on from where the generation left them
+        random.state = prepared->randomState;
+    } else {
+        createEnemies(_size, _enemynum);
+    }
 
-    //setting up timers
-    enemyStepTimer = new QTimer();
-    enemyStepTimer->setInterval(1000 / _enemyspd);
-    timeCounter = new QTimer();
-    timeCounter->setInterval(1000);
-    connect(enemyStepTimer, SIGNAL(timeout()), this, SLOT(moveEnemies()));
-    connect(timeCounter, SIGNAL(timeout()), this, SLOT(timerTimeout()));
+    inputQueue->clear();
+    inputTicks = 0;
+    replayUntil = 0;
+    clearHistory();
 
     paused = false;
+    tableDirty = false;
+    statusDirty = false;
     waitingForExplosion = false;
     explosionDelay = 4;
+    target = player;
+    charges.erase(charges.begin(), charges.end());
+    chargeAt.fill(-1, _size * _size);
+    blasts.erase(blasts.begin(), blasts.end());
+    stampMarks.fill(0, _size * _size);
+    blastMark = 0;
     gameTime = 0;
+    current.ended = false;
+    current.playerWon = false;
+}
+
 
+//For designed levels (see LevelLoader): after a reset without random walls and enemies,
+//the level is drawn onto the empty table with these, before the game starts.
+void GameModel::setTile(int x, int y, TileType t){
+    table[x][y] = t;
+    updateOpenMask(x - 1, x + 1, y - 1, y + 1);
+    updateMinimap(x, x, y, y);
 }
 
-// GameModel::~GameModel(){ }
+void GameModel::placePlayer(int x, int y){
+    player.x = x;
+    player.y = y;
+    player.facing = Right;
+    target = player;
+}
+
+//the enemy counts towards the enemies of the game, like the ones of createEnemies
+void GameModel::placeEnemy(const Position &e){
+    enemies.push_back(e);
+    markEnemy(e);
+    _enemynum++;
+}
+
+//A charge waits on the floor (shown as a target) until a blast reaches it, then goes off in the same tick.
+void GameModel::placeCharge(int x, int y){
+    if (chargeAt[x * _size + y] >= 0) return;
+    Position c = {x, y, Up};
+    chargeAt[x * _size + y] = charges.size();
+    charges.push_back(c);
+    setTile(x, y, TargetFloor);
+}
 
 
 //This method is called when the game starts. It could have been part of this class's constructor,
 //but for unit testing purposes it was separated.
-//Starts the timers for enemies and the time counter.
+//Starts the clock of the game.
 void GameModel::startTimers(){
-    enemyStepTimer->start();
-    timeCounter->start();
+    wallClock.start();
+    lastWallTime = 0;
+    clock->start();
 }
 
 
 //For unit testing purposes.
-//Advances the game, without relying on timeCounter
+//Advances the game by a second, without relying on the clock
 void GameModel::advanceGame(){
     timerTimeout();
 }
 
 
+//For unit testing purposes.
+//Runs the ticks due in the next 'ms' milliseconds of game time, as the clock would, without waiting for it
+void GameModel::advanceClock(int ms){
+    gameClock += qint64(ms) * 1000000;
+    runDueTicks(maxTicksPerTimeout);
+}
+
+
+//For unit testing purposes.
+//Applies the queued commands, without relying on the clock
+void GameModel::advanceInput(){
+    processInput();
+}
+
+
+//Counts where the player dies, the enemies are killed and the blasts hit into 'h' (not owned; 0 turns it off).
+//The heatmap is resized to the board (and so zeroed) whenever the size of the board changes.
+void GameModel::setHeatmap(TileHeatmap* h){
+    heatmap = h;
+    if (heatmap && heatmap->size() != _size) heatmap->resize(_size);
+}
+
+
+//The minimap is built for the current board, and kept up to date from then on.
+void GameModel::setMinimap(MinimapPyramid* m){
+    minimap = m;
+    updateMinimap(0, -1, 0, -1);
+}
+
+
+//Updates the tiles of the minimap in the rows [top, bottom] and the columns [left, right]; an empty range rebuilds it.
+void GameModel::updateMinimap(int top, int bottom, int left, int right){
+    if (!minimap) return;
+    if (top > bottom || minimap->boardSize() != _size) minimap->reset(table);
+    else minimap->update(table, top, bottom, left, right);
+    overviewDirty = true;
+}
+
+
+//Sets the radius of the airstrikes' blast, keeping it a square (3 by default: 7x7).
+bool GameModel::setBlastRadius(int radius){
+    return setBlastStencil(BlastStencil(BlastStencil::Square, radius));
+}
+
+
+//Sets the shape of the airstrikes' blast: it stamps, kills and sets off charges on the tiles of the stencil.
+//Returns false (and keeps the old shape) while an airstrike is on its way or exploding: its explosion is cleared
+//with the shape it was stamped with.
+bool GameModel::setBlastStencil(const BlastStencil &s){
+    if (waitingForExplosion) return false;
+    stencil = s;
+    return true;
+}
+
+
+//Sets how many times per second the player can move (each input tick applies at most one move).
+void GameModel::setPlayerMoveRate(int movesPerSecond){
+    _playerspd = qMax(1, movesPerSecond);
+    inputPeriod = secondPeriod / _playerspd;
+    nextInput = gameClock + inputPeriod;
+    updateClockInterval();
+}
+
+
+//Sets how fast the game runs compared to the wall clock (from 0.25x to 64x; 1 by default).
+//Everything is scaled: the enemies, the countdown of the airstrike, the time counter and the player's move rate.
+void GameModel::setTimeScale(double scale){
+    timeScale = qBound(0.25, scale, 64.0);
+    updateClockInterval();
+}
+
+
+//The clock wakes up about as often as the most frequent tick is due, but at least every 10 ms;
+//the ticks are scheduled by their deadlines, so the interval only affects the latency, not the pace.
+void GameModel::updateClockInterval(){
+    qint64 period = qMin(enemyPeriod, inputPeriod);
+    clock->setInterval(qBound(1, int(period / 1000000 / timeScale), 10));
+}
+
+
 //This method is called right after the table is created in the View.
 void GameModel::requestUpdate(){
     //sends signal to View in order to show the initial state of the game
-    emit tableChanged(table,player,enemies);
+    publishTable();
+    publishStatus();
 }
 
 
@@ -107,10 +346,10 @@ void GameModel::playerMoved(Direction dir){
 
         if (playerDied){
             pauseGame();
-            emit gameEnded(false);
+            endGame(false);
         }
 
-        emit tableChanged(table,player,enemies);
+        notifyTable();
     }
 }
 
@@ -120,16 +359,24 @@ void GameModel::playerMoved(Direction dir){
 void GameModel::pauseGame(){
     if (paused && !playerDied){
         paused = false;
-        enemyStepTimer->start();
-        timeCounter->start();
+        //the time spent paused doesn't count
+        lastWallTime = wallClock.nsecsElapsed();
+        clock->start();
     } else {
         paused = true;
-        enemyStepTimer->stop();
-        timeCounter->stop();
+        clock->stop();
     }
 }
 
 
+//Buffers a command of the user until the next input tick (see processInput).
+//Pausing can't wait for a tick (the ticks stop while the game is paused), so it is done right away.
+void GameModel::queueCommand(const GameModel::Command &c){
+    if (c.type == Command::Pause) pauseGame();
+    else inputQueue->push(c, inputTicks);
+}
+
+
 //stores the focus point (target) of the airstrike
 void GameModel::airstrikeCalled(){
     if( !waitingForExplosion){
@@ -144,14 +391,360 @@ void GameModel::airstrikeCalled(){
 
 //-----PRIVATE METHODS-----
 
+//The clock calls this method every few ms.
+//The game clock is advanced by the elapsed wall time (multiplied by the time scale), and every tick that is due by now
+//is run, in the order of their deadlines. Since the deadlines are kept in game time, late timeouts don't make the game
+//drift: the missed ticks are caught up on at the next timeout. When several ticks are run at once, the View is only
+//notified once, at the end, so a game running faster than the display drops frames instead of slowing down.
+void GameModel::clockTimeout(){
+    qint64 now = wallClock.nsecsElapsed();
+    gameClock += qint64((now - lastWallTime) * timeScale);
+    lastWallTime = now;
+    runDueTicks(maxTicksPerTimeout);
+}
+
+
+//Runs every tick that is due by the game clock (see clockTimeout), but at most 'maxTicks' of them (0: no limit).
+void GameModel::runDueTicks(int maxTicks){
+    batching = true;
+    int ticks = 0;
+    bool due = false;
+    while (!paused){
+        qint64 next = qMin(nextInput, qMin(nextEnemyStep, nextSecond));
+        due = next <= gameClock;
+        if (!due || (maxTicks > 0 && ticks == maxTicks)) break;
+        //ticks due at the same time: the player's input first, then the enemies, then the second
+        if (nextInput == next){
+            nextInput += inputPeriod;
+            processInput();
+        } else if (nextEnemyStep == next){
+            nextEnemyStep += enemyPeriod;
+            moveEnemies();
+        } else {
+            nextSecond += secondPeriod;
+            timerTimeout();
+        }
+        ticks++;
+    }
+    if (due && !paused){
+        //too far behind to catch up: the rest of the delay is given up on
+        gameClock = qMin(nextInput, qMin(nextEnemyStep, nextSecond));
+    }
+    batching = false;
+
+    if (ticks > 1) coalescedUpdates += ticks - 1;
+    if (tableDirty) notifyTable();
+    if (statusDirty) notifyStatus();
+}
+
+
+//Keeps the snapshots of the last 'ticks' input ticks, so that the game can be rolled back to any of them
+//(0 turns it off; that is the default). The snapshots are allocated here and reused, so taking them costs no allocation.
+void GameModel::setRollbackWindow(int ticks){
+    history.resize(qMax(0, ticks));
+    clearHistory();
+}
+
+
+//Restores the state of the game as it was at the beginning of input tick 'tick' (before its input was applied).
+//Returns false if that tick is no longer (or not yet) in the history. The ticks after it can be run again with resimulate().
+bool GameModel::rollbackTo(int tick){
+    if (history.isEmpty() || tick < 0 || tick >= inputTicks) return false;
+    const Snapshot &s = history[tick % history.size()];
+    if (s.state.tick != tick) return false;
+
+    if (replayUntil <= inputTicks) {
+        replayUntil = inputTicks;
+        resumeClock = gameClock;
+    }
+    bool ended = paused && (playerDied || enemies.isEmpty());
+    bool pausedByUser = paused && !ended;
+
+    restoreState(s.state);
+    //the ticks from here on are recorded again as they are simulated again
+    if (recorder) recorder->rewind(tick);
+
+    //the game might have ended since the snapshot (a game paused by the user stays paused)
+    if (pausedByUser){
+        paused = true;
+    } else if (ended){
+        lastWallTime = wallClock.nsecsElapsed();
+        clock->start();
+    }
+    return true;
+}
+
+
+//After a rollback, runs the game again up to where it was, with the inputs stored in the history
+//(as corrected by correctInput). The View is notified only once, at the end.
+void GameModel::resimulate(){
+    if (replayUntil <= inputTicks) return;
+    resimulatedTicks += replayUntil - inputTicks;
+    //the input of the tick rolled back to is due right away; the rest follows by the game clock
+    batching = true;
+    processInput();
+    gameClock = resumeClock;
+    runDueTicks(0);
+    replayUntil = 0;
+}
+
+
+//Replaces the input of a past input tick, and if it differs from what was assumed, rolls the game back
+//to that tick and simulates it again. Returns false if the tick is no longer in the history.
+//This is how a late input is applied: the game goes on with a prediction, then corrects it when the real input arrives.
+bool GameModel::correctInput(int tick, const TickInput &input){
+    if (history.isEmpty() || tick < 0 || tick >= inputTicks) return false;
+    Snapshot &s = history[tick % history.size()];
+    if (s.state.tick != tick) return false;
+    if (s.input.airstrike == input.airstrike && s.input.move == input.move) return true;
+
+    s.input = input;
+    rollbackTo(tick);
+    resimulate();
+    return true;
+}
+
+
+//Stores the state at the beginning of the current input tick into its slot of the history.
+void GameModel::saveSnapshot(const TickInput &input){
+    Snapshot &s = history[inputTicks % history.size()];
+    s.input = input;
+    saveState(s.state);
+}
+
+
+//Empties the history, and makes room in it for the current game.
+void GameModel::clearHistory(){
+    for (int k = 0; k < history.size(); k++){
+        history[k].state.tick = -1;
+        history[k].state.tiles.resize(_size * _size);
+        history[k].state.enemies.reserve(_enemynum);
+    }
+}
+
+
+//Copies the state of the game into 's'. If 's' has been used for a game of the same size before, nothing is allocated.
+void GameModel::saveState(State &s) const{
+    s.tick = inputTicks;
+    s.tiles.resize(_size * _size);
+    for (int i = 0; i < _size; ++i){
+        const TileType* row = table[i].constData();
+        for (int j = 0; j < _size; ++j) s.tiles[i*_size + j] = quint8(row[j]);
+    }
+    s.player = player;
+    s.enemies.resize(enemies.size());
+    for (int k = 0; k < enemies.size(); k++) s.enemies[k] = enemies[k];
+    s.randomState = random.state;
+    s.gameTime = gameTime;
+    s.explosionDelay = explosionDelay;
+    s.waitingForExplosion = waitingForExplosion;
+    s.target = target;
+    s.charges.resize(charges.size());
+    for (int k = 0; k < charges.size(); k++) s.charges[k] = charges[k];
+    s.blasts.resize(blasts.size());
+    for (int k = 0; k < blasts.size(); k++) s.blasts[k] = blasts[k];
+    s.playerDied = playerDied;
+    s.gameClock = gameClock;
+    s.nextEnemyStep = nextEnemyStep;
+    s.nextSecond = nextSecond;
+    s.nextInput = nextInput;
+}
+
+
+//Puts the game back into a saved state (of a game with the same parameters). Returns false if the sizes don't match.
+//The game is not paused afterwards (states are only saved while it runs), but the clock is left alone.
+bool GameModel::restoreState(const State &s){
+    if (s.tiles.size() != _size * _size) return false;
+    for (int i = 0; i < _size; ++i){
+        for (int j = 0; j < _size; ++j) table[i][j] = TileType(s.tiles[i*_size + j]);
+    }
+    updateOpenMask(1, _size - 2, 1, _size - 2);
+    updateMinimap(0, -1, 0, -1);
+    player = s.player;
+    //copied element by element, so that the state and the model never share (and detach) their storage
+    for (int k = 0; k < enemies.size(); k++) unmarkEnemy(enemies[k]);
+    enemies.resize(s.enemies.size());
+    for (int k = 0; k < s.enemies.size(); k++){
+        enemies[k] = s.enemies[k];
+        markEnemy(enemies[k]);
+    }
+    random.state = s.randomState;
+    gameTime = s.gameTime;
+    explosionDelay = s.explosionDelay;
+    waitingForExplosion = s.waitingForExplosion;
+    target = s.target;
+    chargeAt.fill(-1, _size * _size);
+    charges.resize(s.charges.size());
+    for (int k = 0; k < s.charges.size(); k++){
+        charges[k] = s.charges[k];
+        chargeAt[charges[k].x * _size + charges[k].y] = k;
+    }
+    blasts.resize(s.blasts.size());
+    for (int k = 0; k < s.blasts.size(); k++) blasts[k] = s.blasts[k];
+    playerDied = s.playerDied;
+    gameClock = s.gameClock;
+    nextEnemyStep = s.nextEnemyStep;
+    nextSecond = s.nextSecond;
+    nextInput = s.nextInput;
+    inputTicks = s.tick;
+    paused = false;
+    current.ended = false;
+    return true;
+}
+
+
+//From the beginning of an input tick (after restoreState, or after the previous call), applies 'input' as the input
+//of the tick instead of the queued commands, then runs the game up to the beginning of the next input tick.
+//This is how replays are played (see ReplayReader). The View is notified once, at the end.
+void GameModel::stepInputTick(const TickInput &input){
+    if (paused) return;
+    batching = true;
+    forcedInput = &input;
+    processInput();
+    forcedInput = 0;
+    //everything due before the next input tick...
+    gameClock = nextInput - 1;
+    runDueTicks(0);
+    //...which is due now, as in a saved state
+    if (!paused){
+        gameClock = nextInput;
+        nextInput += inputPeriod;
+    }
+}
+
+
+GameModel::Params GameModel::getParams() const{
+    Params params = {_size, _wallnum, _enemynum, _enemyspd, _destroywalls};
+    return params;
+}
+
+
+//Tells the View that the table has changed; while ticks are being caught up on, only notes it (see clockTimeout).
+void GameModel::notifyTable(){
+    if (batching) {
+        tableDirty = true;
+    } else {
+        tableDirty = false;
+        publishTable();
+    }
+}
+
+
+//The same for the status of the game.
+void GameModel::notifyStatus(){
+    if (batching) {
+        statusDirty = true;
+    } else {
+        statusDirty = false;
+        publishStatus();
+    }
+}
+
+
+//Tells the View and the observers that the table has changed.
+void GameModel::publishTable(){
+    emit tableChanged(table,player,enemies);
+    notifyObservers(TableChanged);
+}
+
+
+void GameModel::publishStatus(){
+    current.statusUpdates++;
+    emit statusChanged( _enemynum - enemies.size(), gameTime, waitingForExplosion, explosionDelay);
+    notifyObservers(StatusChanged);
+}
+
+
+void GameModel::endGame(bool playerWon){
+    current.ended = true;
+    current.playerWon = playerWon;
+    emit gameEnded(playerWon);
+    notifyObservers(GameEnded);
+}
+
+
+//Adds a typed observer, and returns the id it can be removed with.
+//Observers are called directly, in the order they subscribed, wherever the model emits a signal (and so they are
+//coalesced the same way while ticks are caught up on): there is no signature lookup, no queuing and no copying,
+//which makes them cheap enough for headless consumers (statistics, recorders, bots) to listen to every update.
+//They run on the model's thread, and must not subscribe or unsubscribe from inside the call.
+int GameModel::subscribe(const Observer &observer){
+    Subscriber s = {nextObserverId++, observer};
+    observers.push_back(s);
+    return s.id;
+}
+
+
+void GameModel::unsubscribe(int id){
+    for (int k = 0; k < observers.size(); k++){
+        if (observers[k].id == id) {
+            observers.remove(k);
+            return;
+        }
+    }
+}
+
+
+//Brings the status fields of the frame up to date, and calls the observers with it.
+void GameModel::notifyObservers(Event e){
+    if (observers.isEmpty()) return;
+    current.bombedEnemies = _enemynum - enemies.size();
+    current.gameTime = gameTime;
+    current.airstrike = waitingForExplosion;
+    current.countdown = explosionDelay;
+    current.target = target;
+    current.paused = paused;
+    if (minimap && overviewDirty){
+        overviewDirty = false;
+        minimap->writeOverview(current.overview);
+        current.overviewCells = minimap->overviewCells();
+    }
+    const Subscriber* s = observers.constData();
+    for (int k = 0; k < observers.size(); k++) s[k].observer(current, e);
+}
+
+
+//The clock calls this method at the player's move rate.
+//The queued commands are applied in order, until the first move: so the player moves at most once per tick,
+//and the same sequence of commands always has the same effect, no matter how fast the keys were pressed.
+//When the game is simulated again after a rollback, the input of the tick comes from the history instead.
+void GameModel::processInput(){
+    if (paused) return;
+    TickInput input = {false, -1};
+    if (forcedInput) {
+        input = *forcedInput;
+    } else if (inputTicks < replayUntil) {
+        input = history[inputTicks % history.size()].input;
+    } else {
+        //the commands are aged in input ticks, not by the wall clock: however many ticks a timeout catches up on,
+        //and however long they take, the same commands are applied at the same ticks
+        Command c;
+        while (inputQueue->pop(c, inputTicks, maxInputAge)){
+            if (c.type == Command::Airstrike) {
+                input.airstrike = true;
+            } else {
+                input.move = c.dir;
+                break;
+            }
+        }
+    }
+    if (!history.isEmpty()) saveSnapshot(input);
+    if (recorder) recorder->record(*this, input);
+    inputTicks++;
+
+    if (input.airstrike) airstrikeCalled();
+    if (input.move >= 0) playerMoved(Direction(input.move));
+}
+
+
 //put M number of walls on a N*N matrix
 //TODO: constraints could be added, in order to reduce the chance of walling off entire areas; or use path finding algorithms
 void GameModel::createWalls(const int &N, const int &M){
     int xPos, yPos;
     int placedWallNum = 0;
     while (placedWallNum < M){
-        xPos = qrand() % (N-2) + 1;
-        yPos = qrand() % (N-2) + 1;
+        xPos = random.bounded(N-2) + 1;
+        yPos = random.bounded(N-2) + 1;
         //walls won't be generated in the immediate vicinity of the player's starting position
         if( !(xPos == 1 && yPos == 1) && table[xPos][yPos] == Floor && !(xPos < 6 && yPos < 6)){
             table[xPos][yPos] = Wall;
@@ -163,20 +756,19 @@ void GameModel::createWalls(const int &N, const int &M){
 
 
 //generates M number of enemies on a N*N matrix
-//TODO: performance could be improved by storing enemies in ordered list, making the 'unique position check' faster
 void GameModel::createEnemies(const int &N, const int &M){
     int enemyNum = 0;
     Position newEnemy;
     int tmp;
     while (enemyNum < M){
         //enemies won't be generated in the immediate vicinity of the player's starting position
-        newEnemy.x = qrand() % (N-2-(N/4)) + 1 + (N/4);
-        newEnemy.y = qrand() % (N-2-(N/4)) + 1 + (N/4);
+        newEnemy.x = random.bounded(N-2-(N/4)) + 1 + (N/4);
+        newEnemy.y = random.bounded(N-2-(N/4)) + 1 + (N/4);
         //check all the other enemies, so that 2 won't start on the same tile
         //also making sure that we aren't placing them on walls
         if( checkEnemyNewPos(newEnemy.x, newEnemy.y) ){
             //finally, specifying a new random direction...
-            tmp = qrand() % 4;
+            tmp = random.bounded(4);
             switch (tmp){
                 case 0 : newEnemy.facing = Up; break;
                 case 1 : newEnemy.facing = Down; break;
@@ -185,84 +777,107 @@ void GameModel::createEnemies(const int &N, const int &M){
             }
             //...and adding the new enemy to the others
             enemies.push_back(newEnemy);
+            markEnemy(newEnemy);
             enemyNum++;
         }
     }
 }
 
 
+//The enemy 'k' stepped into the explosion at (x,y): it is removed.
+void GameModel::enemyWalkedIntoBlast(int k, int x, int y){
+    if (heatmap) heatmap->enemyKilled(x, y);
+    unmarkEnemy(enemies[k]);
+    enemies.remove(k);
+}
+
+
+//A blocked enemy turns to one of the other directions it can walk to (by openMask), so it doesn't waste its
+//next step on another wall; an enemy walled in on every side waits.
+void GameModel::turnEnemy(Position &e){
+    e.facing = Direction(turnToOpen(openMask[e.x * _size + e.y], e.facing, random));
+    markEnemy(e);
+}
+
+
+//Updates the open directions (see openmask.h) of the inner tiles in the rows [top, bottom] and the columns [left, right],
+//after the tiles around them have changed.
+void GameModel::updateOpenMask(int top, int bottom, int left, int right){
+    top = qMax(top, 1);
+    left = qMax(left, 1);
+    bottom = qMin(bottom, _size - 2);
+    right = qMin(right, _size - 2);
+    for (int i = top; i <= bottom; ++i){
+        const TileType* up = table[i-1].constData();
+        const TileType* row = table[i].constData();
+        const TileType* down = table[i+1].constData();
+        quint8* mask = openMask.data() + i * _size;
+        for (int j = left; j <= right; ++j) mask[j] = openDirections(up, row, down, j);
+    }
+}
+
+
 //This method moves each enemy one tile in their specified direction.
-//If that new tile contains an explosion, the enemy is deleted;
-//if that direction isn't valid (wall, or other enemy) they choose a new random direction instead.
+//If that new tile contains an explosion, the enemy is deleted (the ones after it are moved down in place,
+//so the storage is kept, and the enemy after it doesn't move in this step);
+//if that direction isn't valid (wall, or other enemy) they choose a new random direction instead (see turnEnemy).
 void GameModel::moveEnemies(){
-    int tmp;
-    for(QList<Position>::iterator it = enemies.begin(); it < enemies.end(); it++){
+    for (int k = 0; k < enemies.size(); k++){
+        Position* it = &enemies[k];
 
         if (it->facing == Up){
-            if(table[it->x-1][it->y] == FloorUnderExplosion) enemies.erase(it);
+            if(table[it->x-1][it->y] == FloorUnderExplosion) enemyWalkedIntoBlast(k, it->x - 1, it->y);
             else if ( checkEnemyNewPos(it->x - 1, it->y) ) {
+                unmarkEnemy(*it);
                 it->x--;
+                markEnemy(*it);
             } else {
-                tmp = qrand() % 3;
-                switch (tmp){
-                    case 0 : it->facing = Right; break;
-                    case 1 : it->facing = Down; break;
-                    case 2 : it->facing = Left; break;
-                }
+                turnEnemy(*it);
             }
         } else if (it->facing == Right){
-            if(table[it->x][it->y+1] == FloorUnderExplosion) enemies.erase(it);
+            if(table[it->x][it->y+1] == FloorUnderExplosion) enemyWalkedIntoBlast(k, it->x, it->y + 1);
             else if ( checkEnemyNewPos(it->x, it->y + 1) ) {
+                unmarkEnemy(*it);
                 it->y++;
+                markEnemy(*it);
             } else {
-                tmp = qrand() % 3;
-                switch (tmp){
-                    case 0 : it->facing = Up; break;
-                    case 1 : it->facing = Down; break;
-                    case 2 : it->facing = Left; break;
-                }
+                turnEnemy(*it);
             }
         } else if (it->facing == Down){
-            if(table[it->x+1][it->y] == FloorUnderExplosion) enemies.erase(it);
+            if(table[it->x+1][it->y] == FloorUnderExplosion) enemyWalkedIntoBlast(k, it->x + 1, it->y);
             else if ( checkEnemyNewPos(it->x + 1, it->y) ) {
+                unmarkEnemy(*it);
                 it->x++;
+                markEnemy(*it);
             } else {
-                tmp = qrand() % 3;
-                switch (tmp){
-                    case 0 : it->facing = Right; break;
-                    case 1 : it->facing = Up; break;
-                    case 2 : it->facing = Left; break;
-                }
+                turnEnemy(*it);
             }
         } else if (it->facing == Left){
-            if(table[it->x][it->y-1] == FloorUnderExplosion) enemies.erase(it);
+            if(table[it->x][it->y-1] == FloorUnderExplosion) enemyWalkedIntoBlast(k, it->x, it->y - 1);
             else if ( checkEnemyNewPos(it->x, it->y - 1) ) {
+                unmarkEnemy(*it);
                 it->y--;
+                markEnemy(*it);
             } else {
-                tmp = qrand() % 3;
-                switch (tmp){
-                    case 0 : it->facing = Right; break;
-                    case 1 : it->facing = Down; break;
-                    case 2 : it->facing = Up; break;
-                }
+                turnEnemy(*it);
             }
         }
 
     }
 
-    emit tableChanged(table,player,enemies);
+    notifyTable();
 
     if(playerDied){
         pauseGame();
-        emit gameEnded(false);
+        endGame(false);
     } else if (enemies.size() == 0){
         pauseGame();
-        emit gameEnded(true);
+        endGame(true);
     }
 }
 
 
-//The timecounter calls this method every second.
+//The clock calls this method every second (of game time).
 //This method is responsible for updating the 'elapsed time' counter and it also makes a countdown before an airstrike,
 //calls the appropriate function for 'starting' and 1 sec later for 'finishing' the explosion.
 void GameModel::timerTimeout(){
@@ -279,77 +894,134 @@ void GameModel::timerTimeout(){
     }
 
     gameTime++;
-    emit statusChanged( _enemynum - enemies.size(), gameTime, waitingForExplosion, explosionDelay);
+    notifyStatus();
     if (playerDied) {
-        emit gameEnded(false);
+        endGame(false);
     }
 }
 
 
 //This method is responsible for updating the game table about the explosion.
-//It has 2 different behaviour, depending upon the user's choice of being able to destroy walls or not.
+//It has 2 different behaviour, depending upon the user's choice of being able to destroy walls or not:
+//the work is done by the blast kernels selected for the rules and the size of the board (see blastkernel.h).
 //The parameter 'explosionFinished' determines whether the state of the explosion should be applied or removed.
+//The explosion is that of the airstrike and of every charge it sets off (see detonate).
 void GameModel::bombTarget(bool explosionFinished){
      if (!paused){
-        int x = target.x - 3;
-        int y = target.y - 3;
         if( !explosionFinished ) //applies explosion status
         {
-            for (int i = x; i < x+7; i++){
-                for (int j = y; j < y+7; j++){
-                    if (i > 0 && i < _size-1 && j > 0 && j < _size-1){
-                        if ( _destroywalls || table[i][j] == Floor || table[i][j] == TargetFloor ) {
-                            table[i][j] = FloorUnderExplosion;
-                        }
-                        else table[i][j] = WallUnderExplosion;
-                    }
-                }
-            }
+            detonate();
 
+            if (heatmap) recordBlast();
             //if the player is caught in the explosion, it is game over
-            if( qAbs(player.x - target.x) < 3 && qAbs(player.y - target.y) < 3){
+            if( inBlast(player) ){
                 playerDied = true;
                 pauseGame();
 
-                emit tableChanged(table,player,enemies);
+                notifyTable();
             }
-            //if an enemy is caught in the explosion, they are deleted
-            for(QList<Position>::iterator it = enemies.begin(); it < enemies.end(); it++){
-                if(qAbs(it->x - target.x) < 3 && qAbs(it->y - target.y) < 3){
-                    enemies.erase(it);
-                }
+            //if an enemy is caught in the explosion, they are deleted (in one pass, however many blasts there were)
+            int kept = 0;
+            for (int k = 0; k < enemies.size(); k++){
+                if ( !inBlast(enemies[k]) ) enemies[kept++] = enemies[k];
+                else unmarkEnemy(enemies[k]);
             }
-
+            if (kept < enemies.size()) enemies.erase(enemies.begin() + kept, enemies.end());
 
         } else //removes explosion status
         {
-            for (int i = x; i < x+7; i++){
-                for (int j = y; j < y+7; j++){
-                    if (i > 0 && i < _size && j > 0 && j < _size){
-                        if ( table[i][j] == FloorUnderExplosion ) table[i][j] = Floor;
-                        else if ( table[i][j] == WallUnderExplosion ) table[i][j] = Wall;
-                    }
-                }
+            quint32 mark = nextBlastMark();
+            for (int b = 0; b < blasts.size(); b++){
+                Position c = blasts[b];
+                int r = stencil.radius();
+                blast->clearOnce(table, _size, stencil, c.x, c.y, stampMarks.data(), mark);
+                updateOpenMask(c.x - r - 1, c.x + r + 1, c.y - r - 1, c.y + r + 1);
+                updateMinimap(c.x - r, c.x + r, c.y - r, c.y + r);
             }
+            blasts.erase(blasts.begin(), blasts.end());
         }
     }
 }
 
 
+//The chain reaction of the airstrike: a breadth-first search over the charges, with 'blasts' as the worklist.
+//Each blast stamps the tiles that aren't stamped yet, then looks up the charges under it on the charge index
+//(only the tiles it covers are looked at), and those go to the end of the list to blast in turn.
+//So a reaction of any size takes time linear in its blasts, and every tile is stamped once.
+void GameModel::detonate(){
+    quint32 mark = nextBlastMark();
+    int r = stencil.radius();
+    blasts.erase(blasts.begin(), blasts.end());
+    blasts.push_back(target);
+    for (int b = 0; b < blasts.size(); b++){
+        Position c = blasts[b]; //a copy: the list grows below
+        blast->applyOnce(table, _size, stencil, c.x, c.y, stampMarks.data(), mark);
+        //walls might have been destroyed
+        updateOpenMask(c.x - r - 1, c.x + r + 1, c.y - r - 1, c.y + r + 1);
+        updateMinimap(c.x - r, c.x + r, c.y - r, c.y + r);
+
+        if (charges.isEmpty()) continue;
+        foreach (const BlastStencil::Span &s, stencil.spans()){
+            int i = c.x + s.dx;
+            if (i < 1 || i > _size - 2) continue;
+            const int* at = chargeAt.constData() + i * _size;
+            for (int j = qMax(c.y + s.left, 1); j <= qMin(c.y + s.right, _size - 2); j++){
+                if (at[j] < 0) continue;
+                blasts.push_back(charges[at[j]]);
+                removeCharge(at[j]);
+            }
+        }
+    }
+}
+
+
+//removes a charge that went off; the last one takes its place in the list
+void GameModel::removeCharge(int k){
+    Position gone = charges[k];
+    chargeAt[gone.x * _size + gone.y] = -1;
+    if (k < charges.size() - 1){
+        charges[k] = charges.last();
+        chargeAt[charges[k].x * _size + charges[k].y] = k;
+    }
+    charges.removeLast();
+}
+
+
+//a mark no tile has yet (see BlastKernel::applyOnce); the marks are only wiped when they run out
+quint32 GameModel::nextBlastMark(){
+    if (++blastMark == 0){
+        stampMarks.fill(0);
+        blastMark = 1;
+    }
+    return blastMark;
+}
+
+
+//Counts the blasts that have just started into the heatmap: the tiles they hit, the player and the enemies they kill.
+//Called before the blasts remove the enemies and end the game.
+void GameModel::recordBlast(){
+    for (int b = 0; b < blasts.size(); b++) heatmap->blastHit(blasts[b].x, blasts[b].y, stencil);
+    if (!playerDied && inBlast(player)) heatmap->playerDied(player.x, player.y);
+    const Position* e = enemies.constData();
+    for (int k = 0; k < enemies.size(); k++){
+        if (inBlast(e[k])) heatmap->enemyKilled(e[k].x, e[k].y);
+    }
+}
+
+
 //this function checks whether an enemy can step (or be created) to the specified coordinate:
 //it returns false if it would step on a wall or an enemy
 //it also checks the player's position and turns on a flag if the game is over
 bool GameModel::checkEnemyNewPos(const int x, const int y){
 
     if (x == player.x && y == player.y){
+        if (heatmap && !playerDied) heatmap->playerDied(x, y);
         playerDied = true;
     }
 
 
     if (table[x][y] == Wall || table[x][y] == WallUnderExplosion) return false;
-    foreach(Position e, enemies){
-        if (e.x == x && e.y == y) return false;
-    }
+    if (enemyMap[x * _size + y]) return false;
 
     return true;
 
@@ -364,12 +1036,15 @@ bool GameModel::checkPlayerNewPos(const int &x, const int &y){
     if (table[x][y] == Wall || table[x][y] == WallUnderExplosion) return false;
 
     if (table[x][y] == FloorUnderExplosion) {
+        if (heatmap && !playerDied) heatmap->playerDied(x, y);
         playerDied = true;
         return true;
     }
 
-    foreach(Position e, enemies){
-        if ((e.x == x && e.y == y)) {
+    const Position* e = enemies.constData();
+    for (int k = 0; k < enemies.size(); k++){
+        if ((e[k].x == x && e[k].y == y)) {
+            if (heatmap && !playerDied) heatmap->playerDied(x, y);
             playerDied = true;
             return true;
         }
@@ -7,6 +7,17 @@
 #include <QMetaEnum>
 #include <QTimer>
 #include <QTime>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <functional>
+#include "gamerandom.h"
+#include "blaststencil.h"
+
+class InputQueue;
+class ReplayWriter;
+class TileHeatmap;
+class MinimapPyramid;
+struct BlastFunctions;
 
 class GameModel : public QObject
 {
@@ -22,23 +33,133 @@ public:
         Direction facing;
     };
 
+    //the settings of a game
+    struct Params{
+        int size;
+        int wallnum;
+        int enemynum;
+        int enemyspd;
+        bool destroywalls;
+    };
+
+    //an input of the user, for when it can't be delivered by a direct method call
+    struct Command{
+        enum Type { Move, Airstrike, Pause };
+        Type type;
+        Direction dir;
+        bool repeated; //comes from an auto-repeated key press
+    };
+
+    //what the player did at an input tick: the airstrike is called before the move
+    struct TickInput{
+        bool airstrike;
+        qint8 move; //a Direction, or -1 for not moving
+    };
+
+    //everything that changes during a game, at the beginning of an input tick (see saveState)
+    struct State{
+        int tick;
+        QVector<quint8> tiles; //row after row
+        Position player;
+        QVector<Position> enemies;
+        quint32 randomState;
+        int gameTime;
+        int explosionDelay;
+        bool waitingForExplosion;
+        Position target;
+        QVector<Position> charges; //the charges still on the board (see placeCharge)
+        QVector<Position> blasts;  //the centers of the explosion on the board, if there is one
+        bool playerDied;
+        qint64 gameClock, nextEnemyStep, nextSecond, nextInput;
+    };
+
+    //everything the View needs for displaying the state of the game
+    struct Frame{
+        QVector< QVector<TileType> > table;
+        Position player;
+        QVector<Position> enemies;
+        QVector<quint8> enemyMap; //the enemies by tile, row after row: 0 for none, otherwise 1 + the enemy's facing
+        int bombedEnemies;
+        int gameTime;
+        bool airstrike;
+        int countdown;
+        Position target = {1, 1, Up}; //where the airstrike lands, while there is one
+        int statusUpdates;  //increased by each statusChanged, so that the View knows when to refresh the panel
+        bool paused;
+        bool ended;
+        bool playerWon;
+        QVector<quint8> overview; //the minimap, if the model has one (see MinimapPyramid::writeOverview)
+        int overviewCells;        //per side
+    };
+
+    //what an observer is told about: the same as the signals
+    enum Event { TableChanged, StatusChanged, GameEnded };
+    //A typed observer of the model (see subscribe): a function pointer, a functor or a lambda.
+    //'frame' is the model's own, and only valid during the call.
+    typedef std::function<void (const Frame &frame, Event e)> Observer;
+
     explicit GameModel(int size, int wallnum, int enemynum, int enemyspd, bool destroywalls);
-    //~GameModel();
+    ~GameModel();
+    void reset(const Params &params, quint32 seed);
+    bool reset(const Params &params, quint32 seed, const State &prepared);
     void startTimers();
     void requestUpdate();
     void advanceGame();
+    void advanceInput();
+    void advanceClock(int ms);
+    void setPlayerMoveRate(int movesPerSecond);
+    bool setBlastRadius(int radius);
+    bool setBlastStencil(const BlastStencil &stencil);
+    void setTimeScale(double scale);
+    void setRollbackWindow(int ticks);
+    bool rollbackTo(int tick);
+    void resimulate();
+    bool correctInput(int tick, const TickInput &input);
+    void saveState(State &s) const;
+    bool restoreState(const State &s);
+    void stepInputTick(const TickInput &input);
+    void setRecorder(ReplayWriter* writer) {recorder = writer;}
+    void setHeatmap(TileHeatmap* h);
+    void setMinimap(MinimapPyramid* m);
+    void setTile(int x, int y, TileType t);
+    void placePlayer(int x, int y);
+    void placeEnemy(const Position &e);
+    void placeCharge(int x, int y);
+    int subscribe(const Observer &observer);
+    void unsubscribe(int id);
 
-    bool gamePaused() {return paused;}
-    Position getPlayer() {return player;}
-    QList<Position> getEnemies() {return enemies;}
-    QVector< QVector<TileType> > getTable() {return table;}
-    bool getPlayerDied(){return playerDied;}
+    bool gamePaused() const {return paused;}
+    Position getPlayer() const {return player;}
+    QVector<Position> getEnemies() const {return enemies;}
+    QVector< QVector<TileType> > getTable() const {return table;}
+    //the same without copying, for readers that only look
+    const QVector<Position>& enemiesRef() const {return enemies;}
+    //kept up to date as the enemies move and die, so the enemies on a part of the board are found by its tiles
+    const QVector<quint8>& enemyMapRef() const {return enemyMap;}
+    const QVector< QVector<TileType> >& tableRef() const {return table;}
+    const QVector<Position>& chargesRef() const {return charges;}
+    int getSize() const {return _size;}
+    Params getParams() const;
+    int getPlayerMoveRate() const {return _playerspd;}
+    int getBlastRadius() const {return stencil.radius();}
+    const BlastStencil& getBlastStencil() const {return stencil;}
+    bool getPlayerDied() const {return playerDied;}
+    int getInputTicks() const {return inputTicks;}
+    int getGameTime() const {return gameTime;}
+    quint32 getSeed() const {return seed;}
+    double getTimeScale() const {return timeScale;}
+    int getCoalescedUpdates() const {return coalescedUpdates;}
+    //the state of the game as the observers see it; the status fields are up to date as of the last notification
+    const Frame& currentFrame() const {return current;}
+    int getResimulatedTicks() const {return resimulatedTicks;}
+    const InputQueue& getInputQueue(){return *inputQueue;}
 
 
 public slots:
     void pauseGame();
     void airstrikeCalled();
     void playerMoved(Direction dir);
+    void queueCommand(const GameModel::Command &c);
 
 
 private:
@@ -48,32 +169,104 @@ private:
     int _enemynum;
     int _enemyspd;
     bool _destroywalls;
+    int _playerspd;
+    BlastStencil stencil;    //the shape of the airstrikes' blast
 
-    Position player;
-    QList<Position> enemies;
-    QVector< QVector<TileType> > table;
+    //the table, the player and the enemies are kept in a frame, so that the observers get them without copying
+    Frame current;
+    Position &player;
+    QVector<Position> &enemies;
+    QVector<quint8> &enemyMap;
+    QVector< QVector<TileType> > &table;
+    quint32 seed;
+    GameRandom random;
 
     int gameTime;
     bool paused;
-    QTimer* enemyStepTimer;
-    QTimer* timeCounter;
+    //one timer drives the whole game: at each timeout, every tick that is due by the game clock is run (see clockTimeout)
+    QTimer* clock;
+    QElapsedTimer wallClock;
+    qint64 lastWallTime;   //ns of wallClock at the previous timeout
+    qint64 gameClock;      //ns of game time: wall time multiplied by the time scale
+    double timeScale;
+    qint64 enemyPeriod, inputPeriod;           //ns of game time between the ticks
+    qint64 nextEnemyStep, nextSecond, nextInput; //when the next ticks are due, by gameClock
+    bool batching;         //ticks are being caught up on: the View is only notified at the end
+    bool tableDirty, statusDirty;
+    int coalescedUpdates;
+
+    //the state of the game at the beginning of an input tick, and the input of that tick (see rollbackTo)
+    struct Snapshot{
+        State state; //its tick is -1 if the slot is empty
+        TickInput input;
+    };
+    QVector<Snapshot> history; //a ring buffer, the snapshot of tick t is at t % history.size()
+    int replayUntil;           //the ticks before this take their input from the history (see resimulate)
+    qint64 resumeClock;        //the game clock before the rollback
+    int resimulatedTicks;
+    const TickInput* forcedInput; //the input of the next input tick, given by stepInputTick
+    ReplayWriter* recorder;       //records the input ticks, if set (not owned)
+    TileHeatmap* heatmap;         //the statistics of the games, if set (not owned)
+    MinimapPyramid* minimap;      //the minimap of the board, if set (not owned)
+    bool overviewDirty;           //the minimap changed since the frame's overview was written
+    InputQueue* inputQueue;
+    int inputTicks;
     int explosionDelay;
     bool waitingForExplosion;
     Position target;
+    QVector<Position> charges;   //placed by designed levels, they go off when a blast reaches them (see detonate)
+    QVector<int> chargeAt;       //the index of the charge on each tile (row after row), or -1
+    QVector<Position> blasts;    //the centers of the explosion: the target, then the charges it set off
+    QVector<quint32> stampMarks; //the tiles stamped by the blasts (see BlastKernel::applyOnce)
+    quint32 blastMark;
+    struct Subscriber{
+        int id;
+        Observer observer;
+    };
+    QVector<Subscriber> observers;
+    int nextObserverId;
+    const BlastFunctions* blast; //the blast kernels for the current rules (see blastkernel.h)
+    QVector<quint8> openMask;    //the open directions of each tile (see openmask.h), kept up to date with the table
     bool playerDied;
 
+    void startGame(const Params &params, quint32 seed, const State* prepared);
     void createWalls(const int &N, const int &M);
     void createEnemies(const int &N, const int &M);
     bool checkEnemyNewPos(const int x, const int y);
+    void turnEnemy(Position &e);
+    void updateOpenMask(int top, int bottom, int left, int right);
     bool checkPlayerNewPos(const int &x, const int &y);
     void bombTarget(bool explosionFinished);
+    void detonate();
+    void removeCharge(int k);
+    quint32 nextBlastMark();
+    bool inBlast(const Position &p) const {return stampMarks[p.x * _size + p.y] == blastMark;}
+    void markEnemy(const Position &e) {enemyMap[e.x * _size + e.y] = quint8(1 + e.facing);}
+    void unmarkEnemy(const Position &e) {enemyMap[e.x * _size + e.y] = 0;}
+    void recordBlast();
+    void updateMinimap(int top, int bottom, int left, int right);
+    void enemyWalkedIntoBlast(int k, int x, int y);
+    void runDueTicks(int maxTicks);
+    void saveSnapshot(const TickInput &input);
+    void clearHistory();
+    void notifyTable();
+    void notifyStatus();
+    void publishTable();
+    void publishStatus();
+    void endGame(bool playerWon);
+    void notifyObservers(Event e);
+    void updateClockInterval();
 
 private slots:
     void moveEnemies();
     void timerTimeout();
+    void processInput();
+    void clockTimeout();
 
 signals:
-    void tableChanged(const QVector< QVector<GameModel::TileType> > &tiles, const GameModel::Position &p, const QList<GameModel::Position> &e);
+    //the arguments are the model's own storage: a receiver that keeps them should copy the elements (not the
+    //containers, which would share the storage), otherwise the model's next change has to detach (reallocate) it
+    void tableChanged(const QVector< QVector<GameModel::TileType> > &tiles, const GameModel::Position &p, const QVector<GameModel::Position> &e);
     void statusChanged(const int eNumber, const int tCounter, const bool airstrike, const int countdown);  
     void gameEnded(const bool playerWon);
 
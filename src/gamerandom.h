@@ -0,0 +1,31 @@
+#ifndef GAMERANDOM_H
+#define GAMERANDOM_H
+
+#include <QtGlobal>
+
+//Small pseudo random number generator (xorshift32) for the game's own use.
+//Unlike qrand(), every game has its own sequence: the same seed always gives the same board and the same
+//enemy decisions, and the whole state is a single number that is cheap to store and restore.
+class GameRandom
+{
+public:
+    explicit GameRandom(quint32 seed = 1) {setSeed(seed);}
+
+    void setSeed(quint32 seed){
+        //spreading the bits, so that neighbouring seeds don't start with similar sequences
+        state = seed * 2654435761u + 0x6D2B79F5u;
+        if (state == 0) state = 1;
+    }
+
+    //returns a number in [0, n)
+    int bounded(int n){
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return int((quint64(state) * quint32(n)) >> 32);
+    }
+
+    quint32 state;
+};
+
+#endif // GAMERANDOM_H
@@ -1,5 +1,7 @@
 #include "gameview.h"
+#include "spectatorpublisher.h"
 #include <QDebug>
+#include <QtMath>
 
 GameView::GameView(QWidget *parent)
     : QWidget(parent)
@@ -15,7 +17,7 @@ GameView::GameView(QWidget *parent)
     mapSizeLabel = new QLabel("Size of the map: 20x20");
     mapSizeSlider = new QSlider(Qt::Horizontal);
     mapSizeSlider->setMinimum(10);
-    mapSizeSlider->setMaximum(30);
+    mapSizeSlider->setMaximum(100); //the board scrolls when it doesn't fit (see BoardWidget)
     mapSizeSlider->setValue(20);
     mapSizeSlider->setMaximumWidth(infoPanelWidth);
     mapSizeSlider->setFocusPolicy(Qt::NoFocus);
@@ -40,10 +42,29 @@ GameView::GameView(QWidget *parent)
     enemySpeedSlider->setValue(3);
     enemySpeedSlider->setMaximumWidth(infoPanelWidth);
     enemySpeedSlider->setFocusPolicy(Qt::NoFocus);
+    playerSpeedLabel = new QLabel("Player speed: 8");
+    playerSpeedSlider = new QSlider(Qt::Horizontal);
+    playerSpeedSlider->setMinimum(2);
+    playerSpeedSlider->setMaximum(20);
+    playerSpeedSlider->setValue(8);
+    playerSpeedSlider->setMaximumWidth(infoPanelWidth);
+    playerSpeedSlider->setFocusPolicy(Qt::NoFocus);
+    gameSpeedLabel = new QLabel("Game speed: 1x");
+    gameSpeedSlider = new QSlider(Qt::Horizontal);
+    gameSpeedSlider->setMinimum(-2); //the speed is 2^value: 0.25x .. 64x
+    gameSpeedSlider->setMaximum(6);
+    gameSpeedSlider->setValue(0);
+    gameSpeedSlider->setMaximumWidth(infoPanelWidth);
+    gameSpeedSlider->setFocusPolicy(Qt::NoFocus);
     destroyWallLabel = new QLabel("     Walls are destructible: ");
     destroyWallButton = new QRadioButton();
     destroyWallButton->setFocusPolicy(Qt::NoFocus);
     destroyWallButton->setChecked(true);
+    threadedLabel = new QLabel("     Simulation on its own thread: ");
+    threadedButton = new QRadioButton();
+    threadedButton->setFocusPolicy(Qt::NoFocus);
+    threadedButton->setAutoExclusive(false);
+    threadedButton->setChecked(false);
 
     newGameButton = new QPushButton(trUtf8("Launch mission"));
     QFont font = newGameButton->font();
@@ -56,7 +77,7 @@ GameView::GameView(QWidget *parent)
     enemyCounterLabel->setAlignment(Qt::AlignHCenter);
     enemyCounterLabel->setFont(QFont("Times New Roman", 20, QFont::Bold));
     enemyCounterLabel->setMaximumWidth(infoPanelWidth);
-    infoLabel = new QLabel("To begin your career, \n click the 'Launch mission' \n button above! \n\n Use W,A,S,D to move, and SPACE \n to call an airstrike!");
+    infoLabel = new QLabel("To begin your career, \n click the 'Launch mission' \n button above! \n\n Use W,A,S,D to move, and SPACE \n to call an airstrike! \n + and - zoom the map.");
     infoLabel->setAlignment(Qt::AlignHCenter);
     infoLabel->setFont(QFont("Times New Roman", 14, QFont::Bold));
     infoLabel->setMaximumWidth(infoPanelWidth);
@@ -66,9 +87,15 @@ GameView::GameView(QWidget *parent)
     pauseButton = new QPushButton(trUtf8("Freeze time!"));
     pauseButton->setFixedSize(infoPanelWidth, 40);
     pauseButton->setFocusPolicy(Qt::NoFocus);
+    replaySlider = new QSlider(Qt::Horizontal);
+    replaySlider->setMaximumWidth(infoPanelWidth);
+    replaySlider->setFocusPolicy(Qt::NoFocus);
+    replaySlider->hide();
 
     //Organizing everything with layouts
-    tableLayout = new QGridLayout();
+    board = new BoardWidget();
+    minimapView = new MinimapWidget();
+    minimapView->setFixedSize(qMin(infoPanelWidth, 200), qMin(infoPanelWidth, 200));
     QVBoxLayout* optionsLayout = new QVBoxLayout();
     optionsLayout->addWidget(mapSizeLabel);
     optionsLayout->addWidget(mapSizeSlider);
@@ -78,21 +105,31 @@ GameView::GameView(QWidget *parent)
     optionsLayout->addWidget(enemyNumberSlider);
     optionsLayout->addWidget(enemySpeedLabel);
     optionsLayout->addWidget(enemySpeedSlider);
+    optionsLayout->addWidget(playerSpeedLabel);
+    optionsLayout->addWidget(playerSpeedSlider);
+    optionsLayout->addWidget(gameSpeedLabel);
+    optionsLayout->addWidget(gameSpeedSlider);
     QHBoxLayout* radioButtonLayout = new QHBoxLayout();
     radioButtonLayout->addWidget(destroyWallLabel);
     radioButtonLayout->addWidget(destroyWallButton);
     optionsLayout->addLayout(radioButtonLayout);
+    QHBoxLayout* threadedButtonLayout = new QHBoxLayout();
+    threadedButtonLayout->addWidget(threadedLabel);
+    threadedButtonLayout->addWidget(threadedButton);
+    optionsLayout->addLayout(threadedButtonLayout);
     optionsLayout->addWidget(newGameButton);
     QVBoxLayout* menuLayout = new QVBoxLayout();
     menuLayout->addLayout(optionsLayout);
     menuLayout->addWidget(enemyCounterLabel);
     menuLayout->addWidget(infoLabel);
+    menuLayout->addWidget(minimapView);
     menuLayout->addWidget(timeCounter);
     menuLayout->addWidget(pauseButton);
+    menuLayout->addWidget(replaySlider);
     menuLayout->setAlignment(Qt::AlignRight);
     menuLayout->setMargin(10);
     QHBoxLayout* mainLayout = new QHBoxLayout();
-    mainLayout->addLayout(tableLayout);
+    mainLayout->addWidget(board, 1);
     mainLayout->addLayout(menuLayout);
     setLayout(mainLayout);
 
@@ -101,108 +138,174 @@ GameView::GameView(QWidget *parent)
     connect(wallNumberSlider, SIGNAL(valueChanged(int)), this, SLOT(setWallNumberText()));
     connect(enemyNumberSlider, SIGNAL(valueChanged(int)), this, SLOT(setEnemyNumberText()));
     connect(enemySpeedSlider, SIGNAL(valueChanged(int)), this, SLOT(setEnemySpeedText()));
+    connect(playerSpeedSlider, SIGNAL(valueChanged(int)), this, SLOT(setPlayerSpeedText()));
+    connect(gameSpeedSlider, SIGNAL(valueChanged(int)), this, SLOT(setGameSpeedText()));
     connect(newGameButton, SIGNAL(clicked()), this, SLOT(generateTable()));
     connect(pauseButton, SIGNAL(clicked()), this, SLOT(pauseGame()));
-
+    connect(replaySlider, SIGNAL(valueChanged(int)), this, SLOT(seekReplay(int)));
+    //the board of the next game is made in the background, and made again when the board's settings change
+    connect(mapSizeSlider, SIGNAL(valueChanged(int)), this, SLOT(prepareBoard()));
+    connect(wallNumberSlider, SIGNAL(valueChanged(int)), this, SLOT(prepareBoard()));
+    connect(enemyNumberSlider, SIGNAL(valueChanged(int)), this, SLOT(prepareBoard()));
+
+    //the table is repainted at most once per display frame
+    frameScheduler = new FrameScheduler(this);
+    connect(frameScheduler, SIGNAL(poll()), this, SLOT(pollSimulation()));
+    connect(frameScheduler, SIGNAL(frameDue()), this, SLOT(presentFrame()));
+    //scrolling or zooming shows a different part of the same frame
+    connect(board, SIGNAL(cameraChanged()), this, SLOT(presentFrame()));
+
+    model = 0;
+    simulation = 0;
     gameBegan = false;
+    replaying = false;
+    estimating = false;
+    framesSinceEstimate = 0;
+    prepareBoard();
 
 }
 
 GameView::~GameView()
 {
+ delete simulation;
  delete model;
 }
 
 
-//After deleting the old one, creates a new GameModel with the specified parameters.
+//Starts a new game with the specified parameters.
+//The model of the previous game is reused (see GameModel::reset).
+//If requested, the game is run on its own thread (see SimulationThread) instead of the GUI thread.
 void GameView::generateTable(){
-    //if there is already a game started, first it has to be cleared
-    if ( gameBegan ) {
-    //if (model != NULL) {
+    //a game running on its own thread is stopped together with its thread
+    frameScheduler->stop();
+    delete simulation;
+    simulation = 0;
+    recorder.finish();
+    replaying = false;
+    replaySlider->hide();
+
+    gameBegan = true;
+    estimating = true;
+    framesSinceEstimate = 0;
+
+
+    //setting up the model for the new game
+    GameModel::Params params = chosenParams();
+    if (!levelFile.isEmpty()){
+        //designed levels are played on the model of the GUI thread
+        if (!model) createModel(params);
+        if (!levels.loadFile(levelFile, *model, params, quint32(QDateTime::currentMSecsSinceEpoch()))){
+            qDebug() << "Could not load the level:" << levels.errorString();
+            model->reset(params, quint32(QDateTime::currentMSecsSinceEpoch()));
+        }
+    } else if (threadedButton->isChecked()){
+        //the model of the GUI thread won't be needed for a while
         delete model;
-        foreach(QVector<QLabel*> rows, gameTable){
-            foreach(QLabel* tile, rows){
-                tableLayout->removeWidget(tile);
-                delete tile;
-            }
+        model = 0;
+        simulation = new SimulationThread(params.size, params.wallnum, params.enemynum, params.enemyspd, params.destroywalls,
+                                          playerSpeedSlider->value(), gameSpeed());
+        simulation->setSpectatorServer(spectatorName);
+        simulation->setRecordFile(recordFile);
+        threadedParams = params;
+        fetchedFrames = 0;
+        shownStatusUpdates = 0;
+        shownEnded = false;
+    } else {
+        //the model is created without walls and enemies: they come with the board below
+        if (!model) {
+            GameModel::Params empty = {params.size, 0, 0, params.enemyspd, params.destroywalls};
+            createModel(empty);
         }
-        gameTable.clear();
+        //the board made in the background during the previous game, if it is still for these settings and it is
+        //made already; otherwise the board is made here (and the one in the making is kept for the next game)
+        GameModel::State board;
+        quint32 seed;
+        if (!boards.take(params, board, seed) || !model->reset(params, seed, board)){
+            model->reset(params, quint32(QDateTime::currentMSecsSinceEpoch()));
+        }
+        boards.prepare(params);
+    }
+    if (model){
+        model->setPlayerMoveRate(playerSpeedSlider->value());
+        model->setTimeScale(gameSpeed());
+        if (!recordFile.isEmpty() && recorder.open(recordFile, *model)) model->setRecorder(&recorder);
+        model->startTimers();
     }
 
-    gameBegan = true;
+    //this->resize(sizeHint()); //automatically resize application window
+    frameScheduler->setPolling(simulation != 0);
+    frameScheduler->start();
+    if (simulation){
+        //the simulation thread publishes the initial state as soon as its model is ready
+        simulation->start();
+    } else {
+        model->requestUpdate();
+    }
+
+    infoLabel->setText("");
+    infoLabel->setFont(QFont("Times New Roman", 25, QFont::Bold));
+    bombedText = "";
+    estimateText = "";
+    enemyCounterLabel->setText("");
+    pauseButton->setDisabled(false);
+}
 
 
-    //creating new model for the new game
-    mapSize = mapSizeSlider->value();
-    //possible improvement: don't delete and recreate the model each time when a new game is started
-    model = new GameModel(mapSize, wallNumberSlider->value(), enemyNumberSlider->value(), enemySpeedSlider->value(), destroyWallButton->isChecked());
+//Creates the model of the GUI thread, and connects it to the View.
+void GameView::createModel(const GameModel::Params &params){
+    model = new GameModel(params.size, params.wallnum, params.enemynum, params.enemyspd, params.destroywalls);
 
-    connect(model, SIGNAL(tableChanged(QVector<QVector<GameModel::TileType> >,GameModel::Position,QList<GameModel::Position>)),
-            this, SLOT(gameModel_refreshTable(QVector<QVector<GameModel::TileType> >,GameModel::Position,QList<GameModel::Position>)));
+    connect(model, SIGNAL(tableChanged(QVector<QVector<GameModel::TileType> >,GameModel::Position,QVector<GameModel::Position>)),
+            this, SLOT(gameModel_tableChanged()));
     connect(model, SIGNAL(statusChanged(int,int,bool,int)), this, SLOT(gameModel_refreshStatus(int,int,bool,int)));
     connect(model,SIGNAL(gameEnded(bool)),this,SLOT(gameModel_gameEnded(bool)));
+    //blasts update the minimap as they happen
+    model->setMinimap(&minimap);
+    //the publisher goes together with the model
+    if (!spectatorName.isEmpty()) new SpectatorPublisher(model, spectatorName, model);
+}
 
-    model->startTimers();
-
-    //creating a label grid as the game table
-    gameTable.resize(mapSize);
-    for (int i = 0; i < mapSize; ++i)
-    {
-        gameTable[i].resize(mapSize);
-        for (int j = 0; j < mapSize; ++j)
-        {
-            gameTable[i][j] = new QLabel(this);
-            gameTable[i][j]->setStyleSheet("border: 1px solid grey");
-            //gameTable[i][j]->setFixedHeight(20);
-            //gameTable[i][j]->setFixedWidth(20);
-            gameTable[i][j]->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Preferred);
-            gameTable[i][j]->setMinimumWidth(this->height() / mapSize);
-            gameTable[i][j]->setMinimumHeight(this->height() / mapSize);
-            gameTable[i][j]->setScaledContents( true );
-            tableLayout->addWidget(gameTable[i][j], i, j);
-        }
-    }
-    //this->resize(sizeHint()); //automatically resize application window
-    model->requestUpdate();
+
+//Shows a recorded game instead of playing one: the slider under the panel scrubs through it.
+//Any tick is shown by going to the nearest keyframe of the recording and simulating from there (see ReplayReader).
+bool GameView::openReplay(const QString &fileName){
+    if (!replay.open(fileName)) return false;
+    frameScheduler->stop();
+    delete simulation;
+    simulation = 0;
+    recorder.finish();
+    if (!model) createModel(replay.params());
+    if (model) model->setRecorder(0);
+
+    gameBegan = true;
+    replaying = true;
+    estimating = false;
+    frameScheduler->setPolling(false);
+    frameScheduler->start();
 
     infoLabel->setText("");
-    infoLabel->setFont(QFont("Times New Roman", 25, QFont::Bold));
     enemyCounterLabel->setText("");
-    pauseButton->setDisabled(false);
+    pauseButton->setDisabled(true);
+    replaySlider->setRange(0, replay.tickCount());
+    replaySlider->show();
+    replaySlider->setValue(0);
+    seekReplay(0);
+    return true;
 }
 
 
-//Updates the appearance of the table.
-//parameters: gametable (floor, wall, or explosion), player, enemies
-void GameView::gameModel_refreshTable(QVector<QVector<GameModel::TileType> > tiles, GameModel::Position p, QList<GameModel::Position> e){
-    for (int i = 0; i < mapSize; ++i)
-    {
-        for (int j = 0; j < mapSize; ++j)
-        {
-            gameTable[i][j]->setPixmap(QPixmap()); //clears any images on the label
-            if (tiles[i][j] == GameModel::Floor) gameTable[i][j]->setStyleSheet("background-color: rgb(249,255,175);");
-            else if (tiles[i][j] == GameModel::Wall) gameTable[i][j]->setStyleSheet("background-color: rgb(139,139,139);");
-
-            if(tiles[i][j] == GameModel::TargetFloor) {
-                gameTable[i][j]->setStyleSheet("background-color: rgb(249,255,175);");
-                QPixmap pix(":/crosshair.png");
-                gameTable[i][j]->setPixmap(pix);
-            }
-            else if (tiles[i][j] == GameModel::FloorUnderExplosion || tiles[i][j] == GameModel::WallUnderExplosion) {
-                QPixmap pix(":/explosion.png");
-                gameTable[i][j]->setPixmap(pix);
-            }
-        }
-    }
-
-    gameTable[p.x][p.y]->setStyleSheet("background-color: rgb(0,70,197);");
+//Shows the recorded game at input tick 'tick'.
+void GameView::seekReplay(int tick){
+    if (replaying && replay.seek(*model, tick)) model->requestUpdate();
+}
 
-    foreach(GameModel::Position enemy, e){
-        gameTable[enemy.x][enemy.y]->setStyleSheet("background-color: rgb(193,0,0);");
-    }
 
+//Only notes that the table has changed; it is shown at the next display frame (see FrameScheduler).
+void GameView::gameModel_tableChanged(){
+    frameScheduler->markDirty();
 }
 
+
 //Updates the informationpanel, displaying the number of enemies slain ("score") and the elapsed time.
 //Indicates the time left before a detonation.
 void GameView::gameModel_refreshStatus(int bombedEnemies, int gameTime, bool airstrike, int countdown){
@@ -211,7 +314,8 @@ void GameView::gameModel_refreshStatus(int bombedEnemies, int gameTime, bool air
     QString textTime = time.toString("mm:ss");
     timeCounter->display(textTime);
 
-    enemyCounterLabel->setText("\nEnemies bombed: " + QString::number(bombedEnemies));
+    bombedText = "\nEnemies bombed: " + QString::number(bombedEnemies);
+    enemyCounterLabel->setText(bombedText + estimateText);
 
     if (airstrike){
         infoLabel->setText("\nAir Strike \n incoming in...\n" + QString::number(countdown));
@@ -230,32 +334,145 @@ void GameView::gameModel_gameEnded(bool playerWon){
         infoLabel->setText("Misson Failed!");
     }
     pauseButton->setDisabled(true);
+    recorder.finish();
+    estimating = false;
+    estimateText = "";
+    //how much the repaints were spared: the model changes merged into a frame, or published and never shown
+    QString frameText = QString("\nFrames: %1 shown,\n%2 of %3 updates\nmerged or dropped")
+            .arg(frameScheduler->presentedFrames())
+            .arg(frameScheduler->coalescedUpdates()).arg(frameScheduler->requestedUpdates());
+    enemyCounterLabel->setText(bombedText + frameText);
+}
+
+
+//Called by 'frameScheduler' once per display frame when the game runs on its own thread.
+//Takes the newest frame published by the simulation thread; the frames published in between are dropped.
+void GameView::pollSimulation(){
+    if (!simulation->fetchFrame()) return;
+    int published = simulation->publishedFrames();
+    frameScheduler->markDirty(published - fetchedFrames);
+    fetchedFrames = published;
+}
+
+
+//Called by 'frameScheduler' when the table has to be repainted.
+void GameView::presentFrame(){
+    if (!simulation){
+        //the model lives on this thread, so its current state can be read directly
+        if (!model) return;
+        board->showFrame(model->tableRef(), model->enemyMapRef(), model->getPlayer());
+        minimap.writeOverview(overviewCells);
+        minimapView->showOverview(overviewCells, minimap.overviewCells(), model->getSize(), model->getPlayer(), model->enemiesRef());
+        if (estimating && !model->gamePaused() && estimateDue()){
+            model->saveState(estimatedState);
+            estimator.submit(model->getParams(), estimatedState);
+        }
+        showEstimate();
+        return;
+    }
+
+    const GameModel::Frame &f = simulation->frame();
+    board->showFrame(f.table, f.enemyMap, f.player);
+    minimapView->showOverview(f.overview, f.overviewCells, f.table.size(), f.player, f.enemies);
+    if (f.statusUpdates != shownStatusUpdates){
+        shownStatusUpdates = f.statusUpdates;
+        gameModel_refreshStatus(f.bombedEnemies, f.gameTime, f.airstrike, f.countdown);
+    }
+    if (f.ended && !shownEnded){
+        shownEnded = true;
+        gameModel_gameEnded(f.playerWon);
+    }
+    if (!f.ended){
+        pauseButton->setText(f.paused ? "Unfreeze time!" : "Freeze time!");
+    }
+    //the frame has no random sequence and no clock, but the playouts don't need them
+    if (estimating && !f.paused && estimateDue()){
+        WinEstimator::stateFromFrame(f, estimatedState);
+        estimator.submit(threadedParams, estimatedState);
+    }
+    showEstimate();
+}
+
+
+//True at every 'estimateInterval'-th frame presented.
+bool GameView::estimateDue(){
+    if (++framesSinceEstimate < estimateInterval) return false;
+    framesSinceEstimate = 0;
+    return true;
+}
+
+
+//Shows the newest estimate of the playouts (see WinEstimator) under the score, if one came since the last frame.
+void GameView::showEstimate(){
+    if (!estimator.fetchEstimate() || !estimating) return;
+    const WinEstimator::Estimate &e = estimator.estimate();
+    if (e.valid){
+        estimateText = QString("\nWin chance: %1%\nRisk: W %2%, A %3%,\nS %4%, D %5%, stay %6%")
+                .arg(qRound(e.winChance * 100))
+                .arg(qRound(e.risk[BatchEnvironment::MoveUp] * 100)).arg(qRound(e.risk[BatchEnvironment::MoveLeft] * 100))
+                .arg(qRound(e.risk[BatchEnvironment::MoveDown] * 100)).arg(qRound(e.risk[BatchEnvironment::MoveRight] * 100))
+                .arg(qRound(e.risk[BatchEnvironment::Stay] * 100));
+    } else {
+        estimateText = "";
+    }
+    enemyCounterLabel->setText(bombedText + estimateText);
+}
+
+
+//Passes an input of the user to the model, wherever it runs.
+//Moves and airstrikes are buffered by the model until its next input tick.
+void GameView::sendCommand(const GameModel::Command &c){
+    if (simulation){
+        simulation->postCommand(c);
+    } else {
+        model->queueCommand(c);
+    }
 }
 
 
 //this method handles keyboard input
 void GameView::keyPressEvent(QKeyEvent* event){
+    //the map can be zoomed at any time, even in a replay
+    switch (event->key()) {
+    case Qt::Key_Plus:
+    case Qt::Key_Equal:
+        board->zoom(1);
+        return;
+    case Qt::Key_Minus:
+        board->zoom(-1);
+        return;
+    case Qt::Key_0:
+        board->zoomToFit();
+        return;
+    }
+    if (!gameBegan || replaying) return;
+    GameModel::Command c;
+    c.type = GameModel::Command::Move;
+    c.repeated = event->isAutoRepeat();
     switch (event->key()) {
     case Qt::Key_Space:
-        model->airstrikeCalled();
+        c.type = GameModel::Command::Airstrike;
         break;
     case Qt::Key_W:
     case Qt::Key_Up:
-        model->playerMoved(GameModel::Up);
+        c.dir = GameModel::Up;
         break;
     case Qt::Key_D:
     case Qt::Key_Right:
-        model->playerMoved(GameModel::Right);
+        c.dir = GameModel::Right;
         break;
     case Qt::Key_S:
     case Qt::Key_Down:
-        model->playerMoved(GameModel::Down);
+        c.dir = GameModel::Down;
         break;
     case Qt::Key_A:
     case Qt::Key_Left:
-        model->playerMoved(GameModel::Left);
+        c.dir = GameModel::Left;
         break;
+    default:
+        return;
     }
+    sendCommand(c);
 }
 
 
@@ -272,15 +489,6 @@ void GameView::resizeEvent(QResizeEvent *){
         infoLabel->setMaximumWidth(infoPanelWidth);
         timeCounter->setFixedSize(infoPanelWidth,80);
         pauseButton->setFixedSize(infoPanelWidth, 40);
-
-        for (int i = 0; i < mapSize; ++i)
-        {
-            for (int j = 0; j < mapSize; ++j)
-            {
-                gameTable[i][j]->setMinimumWidth(this->height() / mapSize);
-                gameTable[i][j]->setMinimumHeight(this->height() / mapSize);
-            }
-        }
     }
 }
 
@@ -289,6 +497,14 @@ void GameView::resizeEvent(QResizeEvent *){
 //Responsible for calling the model's pauseGame method, and changing the interface accordingly.
 void GameView::pauseGame(){
     if(gameBegan){
+        if (simulation){
+            //the button's text is updated when the simulation thread reports the change
+            GameModel::Command c;
+            c.type = GameModel::Command::Pause;
+            c.repeated = false;
+            sendCommand(c);
+            return;
+        }
         model->pauseGame();
         //TODO: don't ask the model, let it emit a signal when the game has paused/continued!
         if (model->gamePaused()){
@@ -323,3 +539,33 @@ void GameView::setEnemyNumberText(){
 void GameView::setEnemySpeedText(){
     enemySpeedLabel->setText("Enemy speed: " + QString::number(enemySpeedSlider->value()) );
 }
+
+//changes the label belonging to 'playerSpeedSlider'
+void GameView::setPlayerSpeedText(){
+    playerSpeedLabel->setText("Player speed: " + QString::number(playerSpeedSlider->value()) );
+}
+
+//the settings of a new game, as chosen on the sliders
+GameModel::Params GameView::chosenParams(){
+    GameModel::Params params = {mapSizeSlider->value(), wallNumberSlider->value(), enemyNumberSlider->value(),
+                                enemySpeedSlider->value(), destroyWallButton->isChecked()};
+    return params;
+}
+
+//starts making the board of the next game for the current settings (see BoardPregenerator)
+void GameView::prepareBoard(){
+    boards.prepare(chosenParams());
+}
+
+//the time scale chosen on 'gameSpeedSlider'
+double GameView::gameSpeed(){
+    return qPow(2.0, gameSpeedSlider->value());
+}
+
+//changes the label belonging to 'gameSpeedSlider', and speeds up or slows down the running game
+//(on the simulation thread, the new speed is taken when the thread wakes up)
+void GameView::setGameSpeedText(){
+    gameSpeedLabel->setText("Game speed: " + QString::number(gameSpeed()) + "x" );
+    if (simulation) simulation->setTimeScale(gameSpeed());
+    else if (model) model->setTimeScale(gameSpeed());
+}
@@ -11,6 +11,15 @@
 #include <QKeyEvent>
 #include <QSlider>
 #include "gamemodel.h"
+#include "simulationthread.h"
+#include "framescheduler.h"
+#include "replay.h"
+#include "levelloader.h"
+#include "boardpregenerator.h"
+#include "boardwidget.h"
+#include "minimapwidget.h"
+#include "minimap.h"
+#include "winestimator.h"
 
 class GameView : public QWidget
 {
@@ -19,6 +28,10 @@ class GameView : public QWidget
 public:
     GameView(QWidget *parent = 0);
     ~GameView();
+    void setSpectatorServer(const QString &name) {spectatorName = name;}
+    void setRecordFile(const QString &fileName) {recordFile = fileName;}
+    void setLevelFile(const QString &fileName) {levelFile = fileName;}
+    bool openReplay(const QString &fileName);
 
 private:
     //properties for the menu/settings bar
@@ -29,23 +42,58 @@ private:
     QLabel* wallNumberLabel;
     QLabel* enemyNumberLabel;
     QLabel* enemySpeedLabel;
+    QLabel* playerSpeedLabel;
+    QLabel* gameSpeedLabel;
     QLabel* destroyWallLabel;
     QRadioButton* destroyWallButton;
+    QLabel* threadedLabel;
+    QRadioButton* threadedButton;
     QSlider* mapSizeSlider;
     QSlider* wallNumberSlider;
     QSlider* enemyNumberSlider;
     QSlider* enemySpeedSlider;
+    QSlider* playerSpeedSlider;
+    QSlider* gameSpeedSlider;
     QPushButton* newGameButton;
     QPushButton* pauseButton;
+    QSlider* replaySlider;
 
-    //properties for the game table
-    QGridLayout* tableLayout;
-    QVector<QVector<QLabel*> > gameTable;
+    //the game table, and its overview in the info column
+    BoardWidget* board;
+    MinimapWidget* minimapView;
 
     //other properties
     GameModel* model;
-    int mapSize;
+    SimulationThread* simulation; //used instead of 'model' when the game runs on its own thread
+    FrameScheduler* frameScheduler;
+    int fetchedFrames;
+    int shownStatusUpdates;
+    bool shownEnded;
     bool gameBegan;
+    QString spectatorName; //if set, the games are streamed to spectators (see SpectatorPublisher)
+    QString recordFile;    //if set, the games are recorded into this file (see ReplayWriter)
+    QString levelFile;     //if set, the games are played on this designed level (see LevelLoader)
+    LevelLoader levels;
+    BoardPregenerator boards; //makes the board of the next game while the current one is played
+    ReplayWriter recorder;
+    MinimapPyramid minimap;       //the minimap of the model of this thread
+    QVector<quint8> overviewCells;
+    ReplayReader replay;
+    bool replaying;
+    WinEstimator estimator;          //the chance to win and the risk of each move, played out in the background
+    GameModel::State estimatedState;
+    GameModel::Params threadedParams; //the settings of the game on the simulation thread
+    bool estimating;
+    int framesSinceEstimate;
+    QString bombedText, estimateText; //the two parts of 'enemyCounterLabel'
+    static const int estimateInterval = 5; //frames between the states handed to the estimator
+
+    void sendCommand(const GameModel::Command &c);
+    void createModel(const GameModel::Params &params);
+    double gameSpeed();
+    GameModel::Params chosenParams();
+    bool estimateDue();
+    void showEstimate();
 
 private slots:
     //slots responsible for creating new game
@@ -53,14 +101,20 @@ private slots:
     void setWallNumberText();
     void setEnemyNumberText();
     void setEnemySpeedText();
+    void setPlayerSpeedText();
+    void setGameSpeedText();
+    void prepareBoard();
     void generateTable();
 
     //slots responsible for gameplay
     void keyPressEvent(QKeyEvent*);
-    void gameModel_refreshTable(QVector<QVector<GameModel::TileType> > tiles, GameModel::Position p, QList<GameModel::Position> e);
+    void gameModel_tableChanged();
     void gameModel_refreshStatus(int bombedEnemies, int gameTime, bool airstrike,  int countdown);
     void gameModel_gameEnded(bool playerWon);
     void pauseGame();
+    void pollSimulation();
+    void presentFrame();
+    void seekReplay(int tick);
 
     void resizeEvent(QResizeEvent*);
 };
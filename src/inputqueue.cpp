@@ -0,0 +1,65 @@
+#include "inputqueue.h"
+
+InputQueue::InputQueue(){
+    clear();
+}
+
+
+void InputQueue::clear(){
+    first = 0;
+    count = 0;
+    pendingMoves = 0;
+    pendingAirstrike = false;
+    received = 0;
+    merged = 0;
+    dropped = 0;
+}
+
+
+//Adds a command to the end of the queue.
+//An auto-repeated move is merged if there is any move waiting already (the key is being held down,
+//and the player can't move faster than the input ticks anyway), and a second airstrike call is merged
+//into the pending one. If the queue is full, the command is dropped.
+bool InputQueue::push(const GameModel::Command &c, qint64 tick){
+    received++;
+
+    if ( (c.type == GameModel::Command::Move && c.repeated && pendingMoves > 0)
+        || (c.type == GameModel::Command::Airstrike && pendingAirstrike) ){
+        merged++;
+        return false;
+    }
+    if (count == Capacity){
+        dropped++;
+        return false;
+    }
+
+    Entry &e = entries[(first + count) % Capacity];
+    e.command = c;
+    e.tick = tick;
+    count++;
+
+    if (c.type == GameModel::Command::Move) pendingMoves++;
+    else if (c.type == GameModel::Command::Airstrike) pendingAirstrike = true;
+    return true;
+}
+
+
+//Removes the oldest command from the queue; stale commands on the way are dropped.
+bool InputQueue::pop(GameModel::Command &c, qint64 now, qint64 maxAge){
+    while (count > 0){
+        const Entry &e = entries[first];
+        first = (first + 1) % Capacity;
+        count--;
+
+        if (e.command.type == GameModel::Command::Move) pendingMoves--;
+        else if (e.command.type == GameModel::Command::Airstrike) pendingAirstrike = false;
+
+        if (now - e.tick > maxAge){
+            dropped++;
+        } else {
+            c = e.command;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,44 @@
+#ifndef INPUTQUEUE_H
+#define INPUTQUEUE_H
+
+#include "gamemodel.h"
+
+//Buffers the user's moves and airstrike calls until the model's next input tick.
+//Every command is stamped with the input tick it arrives before; redundant ones (auto-repeated keys while a move is
+//already waiting, a second airstrike call) are merged into the pending ones, and commands that waited
+//too long are discarded, so holding down a key can't queue up moves for the future.
+class InputQueue
+{
+public:
+    InputQueue();
+
+    void clear();
+    //returns false if the command was merged into a pending one or dropped
+    bool push(const GameModel::Command &c, qint64 tick);
+    //takes the oldest pending command that is not older than 'maxAge' input ticks at the tick 'now'
+    bool pop(GameModel::Command &c, qint64 now, qint64 maxAge);
+
+    bool isEmpty() const {return count == 0;}
+    int receivedCommands() const {return received;}
+    int mergedCommands() const {return merged;}
+    int droppedCommands() const {return dropped;}
+
+private:
+    enum { Capacity = 16 };
+
+    struct Entry{
+        GameModel::Command command;
+        qint64 tick;
+    };
+
+    Entry entries[Capacity];
+    int first;
+    int count;
+    int pendingMoves;
+    bool pendingAirstrike;
+    int received;
+    int merged;
+    int dropped;
+};
+
+#endif // INPUTQUEUE_H
@@ -0,0 +1,187 @@
+#include "levelloader.h"
+#include <QDataStream>
+#include <QFile>
+
+static const quint32 levelMagic = 0x424D4C56; //"BMLV"
+static const quint16 formatVersion = 1;
+//the enemies of the text form, by their facing (in the order of GameModel::Direction)
+static const char enemyChars[] = "^>v<";
+
+
+LevelLoader::LevelLoader()
+{
+}
+
+
+bool LevelLoader::load(QIODevice &device, GameModel &model, const GameModel::Params &rules, quint32 seed){
+    error.clear();
+    if (device.peek(4) == QByteArray("BMLV")) return loadBinary(device, model, rules, seed);
+    return loadText(device, model, rules, seed);
+}
+
+
+bool LevelLoader::loadFile(const QString &fileName, GameModel &model, const GameModel::Params &rules, quint32 seed){
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) return fail(fileName + ": " + file.errorString());
+    return load(file, model, rules, seed);
+}
+
+
+bool LevelLoader::fail(const QString &message){
+    error = message;
+    return false;
+}
+
+
+//Reads the next line into 'row', without its line break. Returns false at the end of the device.
+bool LevelLoader::readTextRow(QIODevice &device){
+    if (device.atEnd()) return false;
+    //a row can't be longer than maxSize, plus the line break; the rest of a longer line is read as the next row
+    row = device.readLine(maxSize + 3);
+    while (row.endsWith('\n') || row.endsWith('\r')) row.chop(1);
+    return true;
+}
+
+
+//The first row tells the size, so the game is started on an empty table of that size right after it;
+//the rest of the rows are drawn onto the table as they are read.
+bool LevelLoader::loadText(QIODevice &device, GameModel &model, const GameModel::Params &rules, quint32 seed){
+    if (!readTextRow(device)) return fail("the level is empty");
+    int n = row.size();
+    if (n < 3 || n > maxSize) return fail(QString("line 1: the size must be between 3 and %1").arg(maxSize));
+
+    GameModel::Params params = {n, 0, 0, rules.enemyspd, rules.destroywalls};
+    model.reset(params, seed);
+    bool playerFound = false;
+    for (int i = 0; i < n; ++i){
+        if (i > 0 && !readTextRow(device)) return fail(QString("line %1: missing row, the level is %2 wide").arg(i + 1).arg(n));
+        if (row.size() != n) return fail(QString("line %1: %2 tiles instead of %3").arg(i + 1).arg(row.size()).arg(n));
+        const char* tiles = row.constData();
+        for (int j = 0; j < n; ++j){
+            char c = tiles[j];
+            bool border = i == 0 || j == 0 || i == n-1 || j == n-1;
+            if (border && c != '#') return fail(QString("line %1: the border must be walls").arg(i + 1));
+            if (c == '#'){
+                model.setTile(i, j, GameModel::Wall);
+            } else if (c == 'P'){
+                if (playerFound) return fail(QString("line %1: a second player").arg(i + 1));
+                model.placePlayer(i, j);
+                playerFound = true;
+            } else if (c == 'T'){
+                model.placeCharge(i, j);
+            } else if (c != '.'){
+                const char* facing = c == 'E' ? enemyChars + 1 : qstrchr(enemyChars, c);
+                if (c == '\0' || !facing) return fail(QString("line %1: unknown tile '%2'").arg(i + 1).arg(QChar(c)));
+                GameModel::Position e = {i, j, GameModel::Direction(facing - enemyChars)};
+                model.placeEnemy(e);
+            }
+        }
+    }
+    //blank lines are fine after the last row, anything else means the level isn't square
+    while (readTextRow(device)){
+        if (!row.trimmed().isEmpty()) return fail(QString("more than %1 rows, the level is %1 wide").arg(n));
+    }
+    if (!playerFound) return fail("the level has no player");
+    return true;
+}
+
+
+bool LevelLoader::loadBinary(QIODevice &device, GameModel &model, const GameModel::Params &rules, quint32 seed){
+    QDataStream in(&device);
+    quint32 magic;
+    quint16 version, size;
+    in >> magic >> version >> size;
+    if (in.status() != QDataStream::Ok || magic != levelMagic) return fail("not a level");
+    if (version != formatVersion) return fail(QString("unknown version %1").arg(version));
+    int n = size;
+    if (n < 3 || n > maxSize) return fail(QString("the size must be between 3 and %1").arg(maxSize));
+
+    GameModel::Params params = {n, 0, 0, rules.enemyspd, rules.destroywalls};
+    model.reset(params, seed);
+    int rowBytes = (n + 7) / 8;
+    row.resize(rowBytes);
+    for (int i = 0; i < n; ++i){
+        if (in.readRawData(row.data(), rowBytes) != rowBytes) return fail(QString("row %1 is missing").arg(i + 1));
+        const uchar* bits = reinterpret_cast<const uchar*>(row.constData());
+        for (int j = 0; j < n; ++j){
+            bool wall = bits[j / 8] & (1 << (j % 8));
+            bool border = i == 0 || j == 0 || i == n-1 || j == n-1;
+            if (border && !wall) return fail(QString("row %1: the border must be walls").arg(i + 1));
+            if (wall && !border) model.setTile(i, j, GameModel::Wall);
+        }
+    }
+
+    const QVector< QVector<GameModel::TileType> > &table = model.tableRef();
+    quint16 x, y;
+    quint32 enemyCount;
+    in >> x >> y >> enemyCount;
+    if (in.status() != QDataStream::Ok) return fail("the player is missing");
+    if (x >= n || y >= n || table[x][y] != GameModel::Floor) return fail("the player is not on the floor");
+    model.placePlayer(x, y);
+    if (enemyCount > quint32(n) * quint32(n)) return fail("too many enemies");
+    for (quint32 k = 0; k < enemyCount; k++){
+        quint8 facing;
+        in >> x >> y >> facing;
+        if (in.status() != QDataStream::Ok) return fail(QString("enemy %1 is missing").arg(k + 1));
+        if (x >= n || y >= n || table[x][y] != GameModel::Floor || facing > GameModel::Left) {
+            return fail(QString("enemy %1 is not on the floor").arg(k + 1));
+        }
+        if (x == model.getPlayer().x && y == model.getPlayer().y) return fail(QString("enemy %1 is on the player").arg(k + 1));
+        GameModel::Position e = {x, y, GameModel::Direction(facing)};
+        model.placeEnemy(e);
+    }
+    return true;
+}
+
+
+
+//-----SAVING-----
+
+static bool isWall(GameModel::TileType t){
+    return t == GameModel::Wall || t == GameModel::WallUnderExplosion;
+}
+
+
+bool LevelLoader::saveText(const GameModel &model, QIODevice &device){
+    const QVector< QVector<GameModel::TileType> > &table = model.tableRef();
+    const QVector<GameModel::Position> &enemies = model.enemiesRef();
+    const QVector<GameModel::Position> &charges = model.chargesRef();
+    GameModel::Position p = model.getPlayer();
+    int n = model.getSize();
+    QByteArray line(n + 1, '\n');
+    for (int i = 0; i < n; ++i){
+        for (int j = 0; j < n; ++j) line[j] = isWall(table[i][j]) ? '#' : '.';
+        for (int k = 0; k < charges.size(); k++){
+            if (charges[k].x == i) line[charges[k].y] = 'T';
+        }
+        for (int k = 0; k < enemies.size(); k++){
+            if (enemies[k].x == i) line[enemies[k].y] = enemyChars[enemies[k].facing];
+        }
+        if (p.x == i) line[p.y] = 'P';
+        if (device.write(line) != line.size()) return false;
+    }
+    return true;
+}
+
+
+bool LevelLoader::saveBinary(const GameModel &model, QIODevice &device){
+    const QVector< QVector<GameModel::TileType> > &table = model.tableRef();
+    const QVector<GameModel::Position> &enemies = model.enemiesRef();
+    int n = model.getSize();
+    QDataStream out(&device);
+    out << levelMagic << formatVersion << quint16(n);
+    int rowBytes = (n + 7) / 8;
+    QByteArray bits(rowBytes, 0);
+    for (int i = 0; i < n; ++i){
+        bits.fill(0);
+        for (int j = 0; j < n; ++j){
+            if (isWall(table[i][j])) bits[j / 8] = char(bits[j / 8] | (1 << (j % 8)));
+        }
+        out.writeRawData(bits.constData(), rowBytes);
+    }
+    out << quint16(model.getPlayer().x) << quint16(model.getPlayer().y) << quint32(enemies.size());
+    for (int k = 0; k < enemies.size(); k++){
+        out << quint16(enemies[k].x) << quint16(enemies[k].y) << quint8(enemies[k].facing);
+    }
+    return out.status() == QDataStream::Ok;
+}
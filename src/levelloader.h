@@ -0,0 +1,50 @@
+#ifndef LEVELLOADER_H
+#define LEVELLOADER_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QString>
+#include "gamemodel.h"
+
+//Loads designed levels into a GameModel, instead of the random walls and enemies of GameModel::reset.
+//
+//The text form is one line per row of the (square) table:
+//  '#' wall, '.' floor, 'P' the player (exactly one), 'E' an enemy facing right,
+//  '^' '>' 'v' '<' an enemy facing up, right, down or left, 'T' a charge (see GameModel::placeCharge).
+//The border must be all walls. Blank lines after the last row are ignored.
+//
+//The binary form is the magic "BMLV", the version and the size, then the rows with one bit per tile
+//(set for a wall, the first tile in the lowest bit), then the player and the enemies.
+//
+//Both are read as a stream, a row at a time, straight into the model: a level is never held in memory
+//as a whole, however big it is. The form is told from the first bytes.
+class LevelLoader
+{
+public:
+    LevelLoader();
+
+    //starts a new game on 'model' with the level read from 'device', with the enemy speed and wall rule of 'rules'
+    //(its size and counts are the level's). On failure, the model is left with part of the level:
+    //it must be reset before it is played, and errorString() tells what was wrong.
+    bool load(QIODevice &device, GameModel &model, const GameModel::Params &rules, quint32 seed);
+    bool loadFile(const QString &fileName, GameModel &model, const GameModel::Params &rules, quint32 seed);
+    QString errorString() const {return error;}
+
+    //writes the walls, the player and the enemies of the current game (explosions are left out,
+    //and so are the charges from the binary form)
+    static bool saveText(const GameModel &model, QIODevice &device);
+    static bool saveBinary(const GameModel &model, QIODevice &device);
+
+    static const int maxSize = 1024;
+
+private:
+    QString error;
+    QByteArray row; //the row being read, reused from row to row
+
+    bool loadText(QIODevice &device, GameModel &model, const GameModel::Params &rules, quint32 seed);
+    bool loadBinary(QIODevice &device, GameModel &model, const GameModel::Params &rules, quint32 seed);
+    bool readTextRow(QIODevice &device);
+    bool fail(const QString &message);
+};
+
+#endif // LEVELLOADER_H
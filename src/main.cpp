@@ -1,10 +1,63 @@
 #include "gameview.h"
+#include "frameexporter.h"
 #include <QApplication>
+#include <QStringList>
+#include <QElapsedTimer>
+
+//"--replay <file> --export <directory> [--png] [--tile <pixels>]": writes every tick of the replay into the directory
+//as an image sequence (PPM, or PNG), without the GUI (see FrameExporter)
+static int exportReplay(const QStringList &args){
+    int i = args.indexOf("--replay");
+    int o = args.indexOf("--export");
+    int t = args.indexOf("--tile");
+    if (i < 0 || i + 1 >= args.size() || o + 1 >= args.size()) {
+        qDebug() << "usage: bomber --replay <file> --export <directory> [--png] [--tile <pixels>]";
+        return 1;
+    }
+    ReplayReader replay;
+    if (!replay.open(args[i + 1])) {
+        qDebug() << "Could not open the replay" << args[i + 1];
+        return 1;
+    }
+    GameModel::Params p = replay.params();
+    GameModel model(p.size, p.wallnum, p.enemynum, p.enemyspd, p.destroywalls);
+    FrameExporter exporter(args[o + 1], args.contains("--png") ? FrameExporter::Png : FrameExporter::Ppm,
+                           t >= 0 && t + 1 < args.size() ? args[t + 1].toInt() : 16);
+
+    QElapsedTimer timer;
+    timer.start();
+    //the replay is played forward, so each seek only simulates one tick
+    for (int tick = 0; tick <= replay.tickCount() && replay.seek(model, tick); tick++) exporter.exportFrame(tick, model);
+    bool ok = exporter.waitForDone();
+    qDebug() << exporter.writtenFrames() << "frames written in" << timer.elapsed() << "ms";
+    return ok ? 0 : 1;
+}
 
 int main(int argc, char *argv[])
 {
+    //the export needs no windows (nor a display)
+    for (int k = 1; k < argc; k++){
+        if (qstrcmp(argv[k], "--export") == 0){
+            QCoreApplication a(argc, argv);
+            return exportReplay(a.arguments());
+        }
+    }
+
     QApplication a(argc, argv);
     GameView w;
+    //"--spectate <name>": the games can be watched through a local socket of that name
+    QStringList args = a.arguments();
+    int i = args.indexOf("--spectate");
+    if (i >= 0 && i + 1 < args.size()) w.setSpectatorServer(args[i + 1]);
+    //"--record <file>": the games are recorded into the file (each new game replaces the previous one)
+    i = args.indexOf("--record");
+    if (i >= 0 && i + 1 < args.size()) w.setRecordFile(args[i + 1]);
+    //"--level <file>": the games are played on a designed level (see LevelLoader for the formats)
+    i = args.indexOf("--level");
+    if (i >= 0 && i + 1 < args.size()) w.setLevelFile(args[i + 1]);
+    //"--replay <file>": a recorded game is shown instead, with a slider to scrub through it
+    i = args.indexOf("--replay");
+    if (i >= 0 && i + 1 < args.size()) w.openReplay(args[i + 1]);
     w.show();
 
     return a.exec();
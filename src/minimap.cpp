@@ -0,0 +1,87 @@
+#include "minimap.h"
+
+MinimapPyramid::MinimapPyramid():
+    n(0)
+{
+}
+
+
+//The storage of the levels is kept when the size of the board doesn't change.
+void MinimapPyramid::reset(const QVector<QVector<GameModel::TileType> > &table){
+    n = table.size();
+    int count = 1;
+    for (int size = n; size > overviewSize; size = (size + 1) / 2) count++;
+    levels.resize(n > 0 ? count : 0);
+    for (int l = 0, size = n; l < levels.size(); l++, size = (size + 1) / 2){
+        levels[l].size = size;
+        levels[l].walls.resize(size * size);
+        levels[l].explosions.resize(size * size);
+    }
+    update(table, 0, n - 1, 0, n - 1);
+}
+
+
+//The tiles are read again, then the cells above them are added up again, level by level.
+void MinimapPyramid::update(const QVector<QVector<GameModel::TileType> > &table, int top, int bottom, int left, int right){
+    if (levels.isEmpty()) return;
+    top = qMax(top, 0);
+    left = qMax(left, 0);
+    bottom = qMin(bottom, n - 1);
+    right = qMin(right, n - 1);
+    if (top > bottom || left > right) return;
+
+    Level &tiles = levels[0];
+    for (int i = top; i <= bottom; ++i){
+        const GameModel::TileType* row = table[i].constData();
+        for (int j = left; j <= right; ++j){
+            GameModel::TileType t = row[j];
+            tiles.walls[i * n + j] = t == GameModel::Wall || t == GameModel::WallUnderExplosion;
+            tiles.explosions[i * n + j] = t == GameModel::FloorUnderExplosion || t == GameModel::WallUnderExplosion;
+        }
+    }
+    for (int l = 1; l < levels.size(); l++){
+        top /= 2;
+        bottom /= 2;
+        left /= 2;
+        right /= 2;
+        for (int i = top; i <= bottom; ++i){
+            for (int j = left; j <= right; ++j) updateCell(l, i, j);
+        }
+    }
+}
+
+
+//Adds up the (up to) 4 cells under cell (x,y) of 'level'.
+void MinimapPyramid::updateCell(int level, int x, int y){
+    const Level &below = levels[level - 1];
+    Level &l = levels[level];
+    quint32 walls = 0, explosions = 0;
+    for (int i = 2 * x; i < qMin(2 * x + 2, below.size); ++i){
+        for (int j = 2 * y; j < qMin(2 * y + 2, below.size); ++j){
+            walls += below.walls[i * below.size + j];
+            explosions += below.explosions[i * below.size + j];
+        }
+    }
+    l.walls[x * l.size + y] = walls;
+    l.explosions[x * l.size + y] = explosions;
+}
+
+
+void MinimapPyramid::writeOverview(QVector<quint8> &cells) const{
+    if (levels.isEmpty()) {
+        cells.resize(0);
+        return;
+    }
+    const Level &o = levels.last();
+    int span = 1 << (levels.size() - 1); //tiles per cell side
+    cells.resize(o.size * o.size);
+    quint8* d = cells.data();
+    for (int i = 0; i < o.size; ++i){
+        for (int j = 0; j < o.size; ++j){
+            //the cells at the right and the bottom edge might cover fewer tiles
+            quint32 area = quint32(qMin(span, n - i * span) * qMin(span, n - j * span));
+            int k = i * o.size + j;
+            d[k] = o.explosions[k] > 0 ? explosionCell : quint8(o.walls[k] * 254 / area);
+        }
+    }
+}
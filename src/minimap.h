@@ -0,0 +1,47 @@
+#ifndef MINIMAP_H
+#define MINIMAP_H
+
+#include <QVector>
+#include "gamemodel.h"
+
+//A mip pyramid of the walls and the explosions of a board, for the minimap.
+//Level 0 has a cell for each tile; a cell of each next level adds up the 2x2 cells under it, up to the first level
+//that is at most overviewSize cells wide: the overview, which is what the minimap shows, whatever the size of the board.
+//The model keeps it up to date (see GameModel::setMinimap): a blast only updates the cells above the tiles it hit,
+//so after the game has started, nothing ever goes over the whole board again.
+class MinimapPyramid
+{
+public:
+    static const int overviewSize = 64;
+    //an overview cell with an explosion on it; the others are the density of walls, from 0 to 254
+    static const quint8 explosionCell = 255;
+
+    MinimapPyramid();
+    //builds the pyramid of a whole table
+    void reset(const QVector<QVector<GameModel::TileType> > &table);
+    //the tiles in the rows [top, bottom] and the columns [left, right] changed
+    void update(const QVector<QVector<GameModel::TileType> > &table, int top, int bottom, int left, int right);
+
+    int boardSize() const {return n;}
+    int levelCount() const {return levels.size();}
+    int levelSize(int level) const {return levels[level].size;}
+    //the walls and explosions on the tiles under a cell
+    quint32 walls(int level, int x, int y) const {return levels[level].walls[x * levels[level].size + y];}
+    quint32 explosions(int level, int x, int y) const {return levels[level].explosions[x * levels[level].size + y];}
+    int overviewCells() const {return levels.isEmpty() ? 0 : levels.last().size;}
+    //writes the overview, row after row, one byte per cell (the wall density, or explosionCell)
+    void writeOverview(QVector<quint8> &cells) const;
+
+private:
+    struct Level{
+        int size;
+        QVector<quint32> walls;
+        QVector<quint32> explosions;
+    };
+    int n;
+    QVector<Level> levels;
+
+    void updateCell(int level, int x, int y);
+};
+
+#endif // MINIMAP_H
@@ -0,0 +1,55 @@
+#include "minimapwidget.h"
+#include "minimap.h"
+#include <QPainter>
+
+MinimapWidget::MinimapWidget(QWidget *parent):
+    QWidget(parent), n(0)
+{
+    //from the color of the floor (no walls) to the color of the walls (all walls), as on the board
+    for (int d = 0; d < 255; d++){
+        palette[d] = qRgb(249 + (139 - 249) * d / 254, 255 + (139 - 255) * d / 254, 175 + (139 - 175) * d / 254);
+    }
+    palette[MinimapPyramid::explosionCell] = qRgb(255, 140, 0);
+    player.x = -1;
+    player.y = -1;
+    player.facing = GameModel::Right;
+}
+
+
+void MinimapWidget::showOverview(const QVector<quint8> &cells, int cellsPerSide, int boardSize, const GameModel::Position &p, const QVector<GameModel::Position> &e){
+    n = boardSize;
+    player = p;
+    //copied element by element, to keep the storage
+    enemies.resize(e.size());
+    for (int k = 0; k < e.size(); k++) enemies[k] = e[k];
+
+    if (cellsPerSide <= 0 || cells.size() != cellsPerSide * cellsPerSide) {
+        image = QImage();
+    } else {
+        if (image.width() != cellsPerSide) image = QImage(cellsPerSide, cellsPerSide, QImage::Format_RGB32);
+        const quint8* d = cells.constData();
+        for (int i = 0; i < cellsPerSide; ++i){
+            QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(i));
+            for (int j = 0; j < cellsPerSide; ++j) line[j] = palette[*d++];
+        }
+    }
+    update();
+}
+
+
+void MinimapWidget::paintEvent(QPaintEvent*){
+    if (image.isNull() || n <= 0) return;
+    QPainter painter(this);
+    int side = qMin(width(), height());
+    //a cell is a power of two tiles wide, so the cells might cover a little more than the board, at the right and the bottom edge
+    int span = 1;
+    while (span * image.width() < n) span *= 2;
+    int shown = side * span * image.width() / n;
+    painter.drawImage(QRect(0, 0, shown, shown), image);
+
+    int dot = qMax(2, side / 64);
+    foreach (const GameModel::Position &enemy, enemies){
+        painter.fillRect(enemy.y * side / n, enemy.x * side / n, dot, dot, QColor(193, 0, 0));
+    }
+    if (player.x >= 0) painter.fillRect(player.y * side / n, player.x * side / n, dot + 1, dot + 1, QColor(0, 70, 197));
+}
@@ -0,0 +1,32 @@
+#ifndef MINIMAPWIDGET_H
+#define MINIMAPWIDGET_H
+
+#include <QWidget>
+#include <QImage>
+#include "gamemodel.h"
+
+//Shows the overview of a MinimapPyramid, scaled to the widget, with the player and the enemies as points on it.
+//The cost of a frame is the size of the overview (at most MinimapPyramid::overviewSize squared) and the number of enemies,
+//whatever the size of the board.
+class MinimapWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit MinimapWidget(QWidget *parent = 0);
+
+    //'cells' is the overview, 'cellsPerSide' wide (see MinimapPyramid::writeOverview)
+    void showOverview(const QVector<quint8> &cells, int cellsPerSide, int boardSize, const GameModel::Position &p, const QVector<GameModel::Position> &e);
+
+protected:
+    void paintEvent(QPaintEvent*);
+
+private:
+    QRgb palette[256]; //the color of each overview cell value
+    QImage image;      //the overview, a pixel per cell
+    int n;
+    GameModel::Position player;
+    QVector<GameModel::Position> enemies;
+};
+
+#endif // MINIMAPWIDGET_H
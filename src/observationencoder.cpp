@@ -0,0 +1,118 @@
+#include "observationencoder.h"
+#include <string.h>
+
+//the tile planes each tile type belongs to (Floor, Wall, FloorUnderExplosion, WallUnderExplosion, TargetFloor)
+static const quint8 wallBit[5] = {0, 1, 0, 1, 0};
+static const quint8 explosionBit[5] = {0, 0, 1, 1, 0};
+static const quint8 targetBit[5] = {0, 0, 0, 0, 1};
+
+//row access for the two ways boards are stored
+struct ModelRows{
+    const QVector< QVector<GameModel::TileType> > &table;
+    const GameModel::TileType* operator()(int i) const {return table[i].constData();}
+};
+struct FlatRows{
+    const quint8* tiles;
+    int size;
+    const quint8* operator()(int i) const {return tiles + i * size;}
+};
+
+
+ObservationEncoder::ObservationEncoder(int boardSize, int window):
+    size(boardSize), w(window > 0 ? window : boardSize)
+{
+}
+
+
+//Fills the three tile planes and clears the two entity planes.
+//Without a window the board is copied row by row; with a window, the tiles outside the board are walls.
+template <typename Out, typename Rows>
+void ObservationEncoder::encodeTiles(const Rows &rows, int px, int py, Out* out) const{
+    Out* wall = out + WallPlane * w * w;
+    Out* explosion = out + ExplosionPlane * w * w;
+    Out* target = out + TargetPlane * w * w;
+    memset(out + PlayerPlane * w * w, 0, 2 * w * w * sizeof(Out));
+
+    int x0 = w == size ? 0 : px - w / 2;
+    int y0 = w == size ? 0 : py - w / 2;
+    for (int i = 0; i < w; i++){
+        int x = x0 + i;
+        if (x < 0 || x >= size){
+            for (int j = 0; j < w; j++){
+                wall[i*w + j] = 1;
+                explosion[i*w + j] = 0;
+                target[i*w + j] = 0;
+            }
+            continue;
+        }
+        const auto* row = rows(x);
+        for (int j = 0; j < w; j++){
+            int y = y0 + j;
+            if (y < 0 || y >= size){
+                wall[i*w + j] = 1;
+                explosion[i*w + j] = 0;
+                target[i*w + j] = 0;
+            } else {
+                int t = row[y];
+                wall[i*w + j] = wallBit[t];
+                explosion[i*w + j] = explosionBit[t];
+                target[i*w + j] = targetBit[t];
+            }
+        }
+    }
+}
+
+
+template <typename Out>
+bool ObservationEncoder::encodeModel(const GameModel &model, Out* out) const{
+    if (model.getSize() != size) return false;
+    GameModel::Position p = model.getPlayer();
+    ModelRows rows = {model.tableRef()};
+    encodeTiles(rows, p.x, p.y, out);
+
+    int x0 = w == size ? 0 : p.x - w / 2;
+    int y0 = w == size ? 0 : p.y - w / 2;
+    out[PlayerPlane * w * w + (p.x - x0) * w + (p.y - y0)] = 1;
+    const QVector<GameModel::Position> &enemies = model.enemiesRef();
+    for (int k = 0; k < enemies.size(); k++){
+        int i = enemies[k].x - x0, j = enemies[k].y - y0;
+        if (i >= 0 && i < w && j >= 0 && j < w) out[EnemyPlane * w * w + i * w + j] = 1;
+    }
+    return true;
+}
+
+
+template <typename Out>
+bool ObservationEncoder::encodeGame(const BatchEnvironment &env, int game, Out* out) const{
+    if (env.size() != size) return false;
+    int px = env.playerX(game), py = env.playerY(game);
+    FlatRows rows = {env.tiles(game), size};
+    encodeTiles(rows, px, py, out);
+
+    int x0 = w == size ? 0 : px - w / 2;
+    int y0 = w == size ? 0 : py - w / 2;
+    out[PlayerPlane * w * w + (px - x0) * w + (py - y0)] = 1;
+    for (int k = 0; k < env.enemyCount(game); k++){
+        int i = env.enemyX(game, k) - x0, j = env.enemyY(game, k) - y0;
+        if (i >= 0 && i < w && j >= 0 && j < w) out[EnemyPlane * w * w + i * w + j] = 1;
+    }
+    return true;
+}
+
+
+bool ObservationEncoder::encode(const GameModel &model, quint8* out) const {return encodeModel(model, out);}
+bool ObservationEncoder::encode(const GameModel &model, float* out) const {return encodeModel(model, out);}
+bool ObservationEncoder::encode(const BatchEnvironment &env, int game, quint8* out) const {return encodeGame(env, game, out);}
+bool ObservationEncoder::encode(const BatchEnvironment &env, int game, float* out) const {return encodeGame(env, game, out);}
+
+bool ObservationEncoder::encodeAll(const BatchEnvironment &env, quint8* out) const{
+    if (env.size() != size) return false;
+    for (int e = 0; e < env.count(); e++) encodeGame(env, e, out + e * observationSize());
+    return true;
+}
+
+bool ObservationEncoder::encodeAll(const BatchEnvironment &env, float* out) const{
+    if (env.size() != size) return false;
+    for (int e = 0; e < env.count(); e++) encodeGame(env, e, out + e * observationSize());
+    return true;
+}
@@ -0,0 +1,45 @@
+#ifndef OBSERVATIONENCODER_H
+#define OBSERVATIONENCODER_H
+
+#include "gamemodel.h"
+#include "batchenvironment.h"
+
+//Writes the state of a game into a buffer owned by the caller, as planes of 0/1 values for agents:
+//one plane per Plane below, each 'width() * width()' values, row after row (planes x rows x columns).
+//The board is read where it is stored (GameModel's table, or BatchEnvironment's flat grid), so encoding
+//needs no containers in between and allocates nothing.
+//With a window, only a 'window * window' square centered on the player is encoded; tiles outside the board
+//count as walls.
+//The encoder is made for one board size: encoding a game of another size writes nothing and returns false.
+class ObservationEncoder
+{
+public:
+    enum Plane { WallPlane, ExplosionPlane, TargetPlane, PlayerPlane, EnemyPlane, PlaneCount };
+
+    //'window' == 0 encodes the whole board
+    explicit ObservationEncoder(int boardSize, int window = 0);
+
+    int width() const {return w;}
+    int observationSize() const {return PlaneCount * w * w;}
+
+    bool encode(const GameModel &model, quint8* out) const;
+    bool encode(const GameModel &model, float* out) const;
+    bool encode(const BatchEnvironment &env, int game, quint8* out) const;
+    bool encode(const BatchEnvironment &env, int game, float* out) const;
+    //every game of the environment, one observation after the other
+    bool encodeAll(const BatchEnvironment &env, quint8* out) const;
+    bool encodeAll(const BatchEnvironment &env, float* out) const;
+
+private:
+    int size;
+    int w;
+
+    template <typename Out, typename Rows>
+    void encodeTiles(const Rows &rows, int px, int py, Out* out) const;
+    template <typename Out>
+    bool encodeModel(const GameModel &model, Out* out) const;
+    template <typename Out>
+    bool encodeGame(const BatchEnvironment &env, int game, Out* out) const;
+};
+
+#endif // OBSERVATIONENCODER_H
@@ -0,0 +1,44 @@
+#ifndef OPENMASK_H
+#define OPENMASK_H
+
+#include "gamemodel.h"
+#include "gamerandom.h"
+
+//The open directions of a tile: a 4-bit mask with bit d set if the neighbour in Direction d can be walked onto
+//(it isn't a wall, with or without an explosion on it). A blocked enemy turns to one of these
+//(see GameModel::moveEnemies), so it only waits when it is walled in on every side.
+
+//whether each tile type can be walked onto
+static const quint8 tileOpen[5] = {
+    1, //Floor
+    0, //Wall
+    1, //FloorUnderExplosion
+    0, //WallUnderExplosion
+    1  //TargetFloor
+};
+
+//the number of directions in each mask, and its n-th direction
+static const quint8 openCount[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+static const quint8 openPick[16][4] = {
+    {0, 0, 0, 0}, {0, 0, 0, 0}, {1, 0, 0, 0}, {0, 1, 0, 0},
+    {2, 0, 0, 0}, {0, 2, 0, 0}, {1, 2, 0, 0}, {0, 1, 2, 0},
+    {3, 0, 0, 0}, {0, 3, 0, 0}, {1, 3, 0, 0}, {0, 1, 3, 0},
+    {2, 3, 0, 0}, {0, 2, 3, 0}, {1, 2, 3, 0}, {0, 1, 2, 3}
+};
+
+//the open directions of the inner tile (x,y); 'up', 'row' and 'down' are the rows x-1, x and x+1
+template <typename Cell>
+inline quint8 openDirections(const Cell* up, const Cell* row, const Cell* down, int y){
+    return quint8(tileOpen[up[y]] << GameModel::Up | tileOpen[row[y+1]] << GameModel::Right |
+                  tileOpen[down[y]] << GameModel::Down | tileOpen[row[y-1]] << GameModel::Left);
+}
+
+//The new direction of an enemy facing 'facing' that can't go on: one of the other open directions, at random.
+//Without any, it keeps facing the same way (and so waits). One random number is used either way.
+inline int turnToOpen(quint8 open, int facing, GameRandom &random){
+    int choices = open & ~(1 << facing);
+    if (!choices) choices = 1 << facing;
+    return openPick[choices][random.bounded(openCount[choices])];
+}
+
+#endif // OPENMASK_H
@@ -0,0 +1,103 @@
+#include "referencebot.h"
+
+//steps on the table in each direction (Up, Right, Down, Left), and the action of each
+static const int stepX[4] = {-1, 0, 1, 0};
+static const int stepY[4] = {0, 1, 0, -1};
+static const quint8 moveAction[4] = {BatchEnvironment::MoveUp, BatchEnvironment::MoveRight, BatchEnvironment::MoveDown, BatchEnvironment::MoveLeft};
+
+
+ReferenceBot::ReferenceBot(quint32 seed):
+    random(seed)
+{
+}
+
+
+void ReferenceBot::actAll(const BatchEnvironment &env, quint8* actions){
+    for (int g = 0; g < env.count(); g++) actions[g] = act(env, g);
+}
+
+
+//While its airstrike is coming, the bot takes the step that gets it furthest out of the blast (and from the enemies);
+//otherwise it calls one if an enemy is close, or takes a step towards the nearest enemy, or wanders if it can't get closer.
+quint8 ReferenceBot::act(const BatchEnvironment &env, int game){
+    int px = env.playerX(game), py = env.playerY(game);
+    int first = random.bounded(4); //the directions are tried from a random one, so ties are broken at random
+
+    if (env.airstrikePending(game)){
+        quint8 best = BatchEnvironment::Stay;
+        int bestScore = -(1 << 20);
+        for (int k = 0; k < 5; k++){
+            //the last one is staying
+            int d = (first + k) % 4;
+            int x = k < 4 ? px + stepX[d] : px;
+            int y = k < 4 ? py + stepY[d] : py;
+            if (k < 4 && !walkable(env, game, x, y)) continue;
+            int enemy = nearestEnemy(env, game, x, y);
+            if (enemy == 0) continue;
+            int score = -escapeSteps(env, game, x, y) * 10 + (enemy > 1 ? 5 : 0) + qMin(enemy, 3);
+            if (score > bestScore){
+                bestScore = score;
+                best = k < 4 ? moveAction[d] : quint8(BatchEnvironment::Stay);
+            }
+        }
+        return best;
+    }
+
+    for (int k = 0; k < env.enemyCount(game); k++){
+        if (qAbs(env.enemyX(game, k) - px) <= strikeDistance && qAbs(env.enemyY(game, k) - py) <= strikeDistance){
+            return BatchEnvironment::CallAirstrike;
+        }
+    }
+
+    int closest = nearestEnemy(env, game, px, py);
+    int wander = -1;
+    for (int k = 0; k < 4; k++){
+        int d = (first + k) % 4;
+        int x = px + stepX[d], y = py + stepY[d];
+        if (!walkable(env, game, x, y)) continue;
+        int enemy = nearestEnemy(env, game, x, y);
+        if (enemy <= 1) continue;
+        if (enemy < closest) return moveAction[d];
+        if (wander < 0) wander = d;
+    }
+    return wander >= 0 ? moveAction[wander] : quint8(BatchEnvironment::Stay);
+}
+
+
+//a tile the player can step on without dying (of the tiles themselves)
+bool ReferenceBot::walkable(const BatchEnvironment &env, int game, int x, int y){
+    int t = env.tiles(game)[x * env.size() + y];
+    return t == GameModel::Floor || t == GameModel::TargetFloor;
+}
+
+
+//the fewest steps in a straight line from (x,y) that get out of the blast of the pending airstrike (0 if it is already out)
+int ReferenceBot::escapeSteps(const BatchEnvironment &env, int game, int x, int y){
+    int tx = env.targetX(game), ty = env.targetY(game);
+    const BlastStencil &blast = env.blastStencil();
+    if (!blast.covers(x - tx, y - ty)) return 0;
+    int fewest = 1 << 10;
+    for (int d = 0; d < 4; d++){
+        int cx = x, cy = y;
+        for (int k = 1; k < fewest; k++){
+            cx += stepX[d];
+            cy += stepY[d];
+            if (!walkable(env, game, cx, cy)) break;
+            if (!blast.covers(cx - tx, cy - ty)){
+                fewest = k;
+                break;
+            }
+        }
+    }
+    return fewest;
+}
+
+
+//the distance (in steps, ignoring the walls) from (x,y) to the nearest enemy
+int ReferenceBot::nearestEnemy(const BatchEnvironment &env, int game, int x, int y){
+    int nearest = 1 << 20;
+    for (int k = 0; k < env.enemyCount(game); k++){
+        nearest = qMin(nearest, qAbs(env.enemyX(game, k) - x) + qAbs(env.enemyY(game, k) - y));
+    }
+    return nearest;
+}
@@ -0,0 +1,31 @@
+#ifndef REFERENCEBOT_H
+#define REFERENCEBOT_H
+
+#include "batchenvironment.h"
+#include "gamerandom.h"
+
+//A simple scripted player for the games of a BatchEnvironment: the yardstick the difficulty is measured with
+//(see DifficultyTuner). It walks towards the nearest enemy, calls the airstrike on itself when an enemy is close,
+//then gets out of the blast; it never steps next to an enemy if it can help it. Ties are broken at random.
+class ReferenceBot
+{
+public:
+    explicit ReferenceBot(quint32 seed = 1);
+
+    //the action of the player of game 'game' (a BatchEnvironment::Action)
+    quint8 act(const BatchEnvironment &env, int game);
+    //the actions of every game
+    void actAll(const BatchEnvironment &env, quint8* actions);
+
+    //an enemy this close (in both directions) is worth an airstrike
+    static const int strikeDistance = 2;
+
+private:
+    GameRandom random;
+
+    static bool walkable(const BatchEnvironment &env, int game, int x, int y);
+    static int nearestEnemy(const BatchEnvironment &env, int game, int x, int y);
+    static int escapeSteps(const BatchEnvironment &env, int game, int x, int y);
+};
+
+#endif // REFERENCEBOT_H
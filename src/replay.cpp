@@ -0,0 +1,284 @@
+#include "replay.h"
+
+static const quint32 headerMagic = 0x424D5250; //"BMRP"
+static const quint32 footerMagic = 0x424D5258; //"BMRX"
+//2: blocked enemies turn to open directions only, so version 1 recordings play differently
+//3: the keyframes have the charges and the blasts of chain reactions
+//4: the header has the blast's stencil (its shape, and its rows as BlastStencil::rows draws them) instead of its radius
+static const quint16 formatVersion = 4;
+//the footer ends with its offset (qint64) and the magic (quint32)
+static const int footerTail = 12;
+
+
+static void writePosition(QDataStream &out, const GameModel::Position &p){
+    out << qint16(p.x) << qint16(p.y) << quint8(p.facing);
+}
+
+static void readPosition(QDataStream &in, GameModel::Position &p){
+    qint16 x, y;
+    quint8 facing;
+    in >> x >> y >> facing;
+    p.x = x;
+    p.y = y;
+    p.facing = GameModel::Direction(facing & 3);
+}
+
+static void writePositions(QDataStream &out, const QVector<GameModel::Position> &list){
+    out << qint32(list.size());
+    for (int k = 0; k < list.size(); k++) writePosition(out, list[k]);
+}
+
+//at most 'limit' of them
+static bool readPositions(QDataStream &in, QVector<GameModel::Position> &list, int limit){
+    qint32 count;
+    in >> count;
+    if (in.status() != QDataStream::Ok || count < 0 || count > limit) return false;
+    list.resize(count);
+    for (int k = 0; k < count; k++) readPosition(in, list[k]);
+    return true;
+}
+
+static void writeState(QDataStream &out, const GameModel::State &s){
+    out << qint32(s.tick) << qint32(s.tiles.size());
+    out.writeRawData(reinterpret_cast<const char*>(s.tiles.constData()), s.tiles.size());
+    writePosition(out, s.player);
+    writePositions(out, s.enemies);
+    out << s.randomState << qint32(s.gameTime) << qint32(s.explosionDelay) << s.waitingForExplosion;
+    writePosition(out, s.target);
+    writePositions(out, s.charges);
+    writePositions(out, s.blasts);
+    out << s.playerDied << s.gameClock << s.nextEnemyStep << s.nextSecond << s.nextInput;
+}
+
+static bool readState(QDataStream &in, GameModel::State &s){
+    qint32 tick, cells, gameTime, explosionDelay;
+    in >> tick >> cells;
+    if (in.status() != QDataStream::Ok || cells < 0 || cells > 1024 * 1024) return false;
+    s.tick = tick;
+    s.tiles.resize(cells);
+    in.readRawData(reinterpret_cast<char*>(s.tiles.data()), cells);
+    readPosition(in, s.player);
+    if (!readPositions(in, s.enemies, cells)) return false;
+    in >> s.randomState >> gameTime >> explosionDelay >> s.waitingForExplosion;
+    s.gameTime = gameTime;
+    s.explosionDelay = explosionDelay;
+    readPosition(in, s.target);
+    if (!readPositions(in, s.charges, cells) || !readPositions(in, s.blasts, cells)) return false;
+    in >> s.playerDied >> s.gameClock >> s.nextEnemyStep >> s.nextSecond >> s.nextInput;
+    return in.status() == QDataStream::Ok;
+}
+
+
+
+//-----WRITER-----
+
+ReplayWriter::ReplayWriter():
+    ticks(0)
+{
+    inputs.reserve(keyframeInterval);
+}
+
+ReplayWriter::~ReplayWriter(){
+    finish();
+}
+
+
+bool ReplayWriter::open(const QString &fileName, const GameModel &model){
+    finish();
+    file.setFileName(fileName);
+    //read back too, when a rewind goes back to a block that is written already
+    if (!file.open(QIODevice::ReadWrite | QIODevice::Truncate)) return false;
+    out.setDevice(&file);
+
+    GameModel::Params params = model.getParams();
+    out << headerMagic << formatVersion
+        << qint32(params.size) << qint32(params.wallnum) << qint32(params.enemynum) << qint32(params.enemyspd) << params.destroywalls
+        << model.getSeed() << qint32(model.getPlayerMoveRate())
+        << qint32(model.getBlastStencil().shape()) << model.getBlastStencil().rows() << qint32(keyframeInterval);
+    index.resize(0);
+    inputs.resize(0);
+    keyframe.tick = 0;
+    ticks = 0;
+    return true;
+}
+
+
+//Every 'keyframeInterval' ticks the block so far is written, and a new one begins with a keyframe.
+void ReplayWriter::record(const GameModel &model, const GameModel::TickInput &input){
+    if (!file.isOpen()) return;
+    if (ticks % keyframeInterval == 0){
+        //(after a rewind to the first tick of a block, the block is empty: it begins again with the new keyframe)
+        if (!inputs.isEmpty()) writeBlock();
+        model.saveState(keyframe);
+        inputs.resize(0);
+    }
+    inputs.append(ReplayReader::encodeInput(input));
+    ticks++;
+}
+
+
+//Within the current block only the inputs are cut back. A tick before its keyframe is in a block written already:
+//that block is read back as the current one, and the file is cut off where it began.
+bool ReplayWriter::rewind(int tick){
+    if (!file.isOpen() || tick < 0 || tick > ticks) return false;
+    if (tick < keyframe.tick){
+        int block = index.size() - 1;
+        while (block > 0 && index[block].tick > tick) block--;
+        if (block < 0 || !file.seek(index[block].offset)) return false;
+        QDataStream in(&file);
+        qint32 count;
+        if (!readState(in, keyframe)) return false;
+        in >> count;
+        if (in.status() != QDataStream::Ok || count < 0 || count > keyframeInterval) return false;
+        inputs.resize(count);
+        in.readRawData(reinterpret_cast<char*>(inputs.data()), count);
+        file.resize(index[block].offset);
+        file.seek(index[block].offset);
+        index.resize(block);
+    }
+    inputs.resize(tick - keyframe.tick);
+    ticks = tick;
+    return true;
+}
+
+
+void ReplayWriter::writeBlock(){
+    IndexEntry entry = {keyframe.tick, file.pos()};
+    index.append(entry);
+    writeState(out, keyframe);
+    out << qint32(inputs.size());
+    out.writeRawData(reinterpret_cast<const char*>(inputs.constData()), inputs.size());
+}
+
+
+void ReplayWriter::finish(){
+    if (!file.isOpen()) return;
+    if (ticks > 0) writeBlock();
+
+    qint64 footerOffset = file.pos();
+    out << qint32(index.size());
+    for (int b = 0; b < index.size(); b++) out << index[b].tick << index[b].offset;
+    out << ticks << footerOffset << footerMagic;
+    out.setDevice(0);
+    file.close();
+}
+
+
+
+//-----READER-----
+
+ReplayReader::ReplayReader():
+    _seed(0), moveRate(8), ticks(0), loadedBlock(-1), positioned(0), resimulated(0)
+{
+    _params.size = 0;
+}
+
+
+//Reads the header and the index; the blocks are only read when a seek needs them.
+bool ReplayReader::open(const QString &fileName){
+    file.close();
+    file.setFileName(fileName);
+    loadedBlock = -1;
+    positioned = 0;
+    if (!file.open(QIODevice::ReadOnly) || file.size() < footerTail) return false;
+    QDataStream in(&file);
+
+    quint32 magic;
+    quint16 version;
+    qint32 size, wallnum, enemynum, enemyspd, rate, shape, interval;
+    QList<QByteArray> rows;
+    in >> magic >> version >> size >> wallnum >> enemynum >> enemyspd >> _params.destroywalls
+       >> _seed >> rate >> shape >> rows >> interval;
+    if (in.status() != QDataStream::Ok || magic != headerMagic || version != formatVersion) return false;
+    if (shape == BlastStencil::Custom){
+        if (!BlastStencil::custom(rows, stencil)) return false;
+    } else {
+        stencil = BlastStencil(BlastStencil::Shape(qBound(0, int(shape), int(BlastStencil::Diamond))), rows.size() / 2);
+    }
+    _params.size = size;
+    _params.wallnum = wallnum;
+    _params.enemynum = enemynum;
+    _params.enemyspd = enemyspd;
+    moveRate = rate;
+
+    qint64 footerOffset;
+    file.seek(file.size() - footerTail);
+    in >> footerOffset >> magic;
+    //a recording that was never finished has no index
+    if (magic != footerMagic || footerOffset <= 0 || footerOffset >= file.size()) return false;
+    file.seek(footerOffset);
+    qint32 blocks;
+    in >> blocks;
+    if (in.status() != QDataStream::Ok || blocks < 0) return false;
+    index.resize(blocks);
+    for (int b = 0; b < blocks; b++) in >> index[b].tick >> index[b].offset;
+    in >> ticks;
+    return in.status() == QDataStream::Ok;
+}
+
+
+bool ReplayReader::seek(GameModel &model, int tick){
+    if (tick < 0 || tick > ticks || index.isEmpty()) return false;
+
+    //the last block that begins at or before 'tick'
+    int block = 0;
+    int high = index.size() - 1;
+    while (block < high){
+        int mid = (block + high + 1) / 2;
+        if (index[mid].tick <= tick) block = mid;
+        else high = mid - 1;
+    }
+
+    if (positioned != &model){
+        GameModel::Params params = _params;
+        model.reset(params, _seed);
+        model.setPlayerMoveRate(moveRate);
+        model.setBlastStencil(stencil);
+        positioned = &model;
+    }
+
+    //forward within the block the model is in: no need for the keyframe
+    bool continuing = loadedBlock == block && model.getInputTicks() <= tick && model.getInputTicks() >= index[block].tick;
+    if (!continuing){
+        if (!loadBlock(block) || !model.restoreState(keyframe)) return false;
+    }
+
+    int first = index[block].tick;
+    while (model.getInputTicks() < tick && model.getInputTicks() - first < inputs.size()){
+        model.stepInputTick(decodeInput(inputs[model.getInputTicks() - first]));
+        resimulated++;
+        //the game ended before the tick; the recording is not of this game
+        if (model.gamePaused()) return model.getInputTicks() == tick;
+    }
+    return model.getInputTicks() == tick;
+}
+
+
+bool ReplayReader::loadBlock(int block){
+    if (loadedBlock == block) return true;
+    loadedBlock = -1;
+    if (!file.seek(index[block].offset)) return false;
+    QDataStream in(&file);
+    if (!readState(in, keyframe)) return false;
+    qint32 count;
+    in >> count;
+    if (in.status() != QDataStream::Ok || count < 0 || count > ReplayWriter::keyframeInterval) return false;
+    inputs.resize(count);
+    in.readRawData(reinterpret_cast<char*>(inputs.data()), count);
+    if (in.status() != QDataStream::Ok) return false;
+    loadedBlock = block;
+    return true;
+}
+
+
+//one byte per tick: the airstrike in the top bit, the move in the others (a Direction + 1, or 0 for not moving)
+GameModel::TickInput ReplayReader::decodeInput(quint8 b){
+    GameModel::TickInput input;
+    input.airstrike = b & 0x80;
+    input.move = qint8(int(b & 0x7F) - 1);
+    return input;
+}
+
+quint8 ReplayReader::encodeInput(const GameModel::TickInput &input){
+    return quint8((input.airstrike ? 0x80 : 0) | (input.move + 1));
+}
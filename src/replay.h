@@ -0,0 +1,93 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <QFile>
+#include <QDataStream>
+#include <QVector>
+#include "gamemodel.h"
+
+//The recording of a game: the parameters and the seed, the input of every input tick, and a keyframe
+//(the whole GameModel::State) every 'keyframeInterval' ticks. Since the game is deterministic, any tick can be
+//reached by restoring the keyframe before it and simulating the few ticks in between.
+//
+//The file is a header, then one block per keyframe (the keyframe and the inputs of the ticks after it),
+//then a footer with the index of the blocks (their first tick and their offset in the file). The footer is at
+//a known place from the end of the file, so a reader finds any block without reading the others.
+
+//Records a game; attached to a model with GameModel::setRecorder.
+class ReplayWriter
+{
+public:
+    ReplayWriter();
+    ~ReplayWriter();
+
+    //starts the recording of the game of 'model' (which must be at its first tick), replacing the file
+    bool open(const QString &fileName, const GameModel &model);
+    //called by the model at every input tick, before the input is applied
+    void record(const GameModel &model, const GameModel::TickInput &input);
+    //Forgets the ticks from 'tick' on; called by the model when it rolls back to 'tick' (see GameModel::rollbackTo),
+    //so that the ticks simulated again are recorded again, with their corrected inputs.
+    bool rewind(int tick);
+    //writes the last block and the index; called by the destructor too
+    void finish();
+
+    static const int keyframeInterval = 256;
+
+private:
+    struct IndexEntry{
+        qint32 tick;
+        qint64 offset;
+    };
+
+    QFile file;
+    QDataStream out;
+    GameModel::State keyframe;   //the keyframe of the current block
+    QVector<quint8> inputs;      //the inputs of the current block, one byte per tick
+    QVector<IndexEntry> index;
+    qint32 ticks;
+
+    void writeBlock();
+
+    friend class ReplayReader;
+};
+
+
+//Plays a recording back on a model: seek() puts the model into the state of any tick.
+class ReplayReader
+{
+public:
+    ReplayReader();
+
+    bool open(const QString &fileName);
+    int tickCount() const {return ticks;}
+    const GameModel::Params& params() const {return _params;}
+    quint32 seed() const {return _seed;}
+
+    //puts 'model' into the state at the beginning of input tick 'tick'; the first seek starts a new game on it
+    //(with the recorded parameters). Going forward a little is done from where the model is; anything else
+    //from the nearest keyframe. Returns false if the tick is not in the recording.
+    bool seek(GameModel &model, int tick);
+    //the ticks simulated by the seeks so far
+    int resimulatedTicks() const {return resimulated;}
+
+    static GameModel::TickInput decodeInput(quint8 b);
+    static quint8 encodeInput(const GameModel::TickInput &input);
+
+private:
+    QFile file;
+    GameModel::Params _params;
+    quint32 _seed;
+    int moveRate;
+    BlastStencil stencil;
+    qint32 ticks;
+    QVector<ReplayWriter::IndexEntry> index;
+    int loadedBlock;             //the block in 'keyframe' and 'inputs', or -1
+    GameModel::State keyframe;
+    QVector<quint8> inputs;
+    GameModel* positioned;       //the model last put into a state by this reader
+    int resimulated;
+
+    bool loadBlock(int block);
+};
+
+#endif // REPLAY_H
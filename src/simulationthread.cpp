@@ -0,0 +1,140 @@
+#include "simulationthread.h"
+#include "spectatorpublisher.h"
+#include "replay.h"
+
+
+//-----SIMULATION THREAD-----
+
+//Stores the parameters of the game; the model itself is created on the new thread in run(),
+//so that its timers belong to that thread's event loop.
+SimulationThread::SimulationThread(int size, int wallnum, int enemynum, int enemyspd, bool destroywalls, int playerspd, double timescale, QObject *parent):
+    QThread(parent), _size(size), _wallnum(wallnum), _enemynum(enemynum), _enemyspd(enemyspd), _destroywalls(destroywalls), _playerspd(playerspd), wakePending(0), timeScale(qRound(timescale * 256))
+{
+}
+
+SimulationThread::~SimulationThread(){
+    stop();
+}
+
+
+//Queues a command for the simulation thread, and wakes the thread unless it has been woken already. Never blocks.
+bool SimulationThread::postCommand(const GameModel::Command &c){
+    bool queued = commands.push(c);
+    if (wakePending.testAndSetOrdered(0, 1)) emit commandsPosted();
+    return queued;
+}
+
+
+//Hands a new time scale to the simulation thread, and wakes the thread like postCommand does. Never blocks.
+void SimulationThread::setTimeScale(double scale){
+    timeScale.storeRelease(qRound(scale * 256));
+    if (wakePending.testAndSetOrdered(0, 1)) emit commandsPosted();
+}
+
+
+//Takes the newest frame published by the simulation thread. Never blocks.
+bool SimulationThread::fetchFrame(){
+    return frames.update();
+}
+
+
+//Stops the event loop of the simulation thread and waits for it to finish.
+void SimulationThread::stop(){
+    quit();
+    wait();
+}
+
+
+//The body of the simulation thread: creates the model, starts the game, and runs the event loop until stop() is called.
+void SimulationThread::run(){
+    GameModel model(_size, _wallnum, _enemynum, _enemyspd, _destroywalls);
+    model.setPlayerMoveRate(_playerspd);
+    SimulationWorker worker(&model, this);
+    //owned by the model, like in the View
+    if (!spectatorName.isEmpty()) new SpectatorPublisher(&model, spectatorName, &model);
+    ReplayWriter recorder;
+    if (!recordFile.isEmpty() && recorder.open(recordFile, model)) model.setRecorder(&recorder);
+    model.startTimers();
+    model.requestUpdate();
+    exec();
+}
+
+
+
+//-----SIMULATION WORKER-----
+
+//Copies the elements into the storage 'to' already has, instead of sharing the storage of 'from' (see GameModel::tableChanged).
+//Once the sizes have settled, copying a frame allocates nothing.
+template <typename T>
+static void copyElements(QVector<T> &to, const QVector<T> &from){
+    to.resize(from.size());
+    T* d = to.data();
+    for (int k = 0; k < from.size(); k++) d[k] = from[k];
+}
+
+static void copyFrame(GameModel::Frame &to, const GameModel::Frame &from){
+    to.table.resize(from.table.size());
+    for (int i = 0; i < from.table.size(); ++i) copyElements(to.table[i], from.table[i]);
+    to.player = from.player;
+    copyElements(to.enemies, from.enemies);
+    copyElements(to.enemyMap, from.enemyMap);
+    to.bombedEnemies = from.bombedEnemies;
+    to.gameTime = from.gameTime;
+    to.airstrike = from.airstrike;
+    to.countdown = from.countdown;
+    to.target = from.target;
+    to.statusUpdates = from.statusUpdates;
+    to.paused = from.paused;
+    to.ended = from.ended;
+    to.playerWon = from.playerWon;
+    copyElements(to.overview, from.overview);
+    to.overviewCells = from.overviewCells;
+}
+
+
+SimulationWorker::SimulationWorker(GameModel *m, SimulationThread *t):
+    model(m), thread(t), appliedTimeScale(t->timeScale.loadAcquire())
+{
+    model->setTimeScale(appliedTimeScale / 256.0);
+    //the model and the worker live on the same thread, so the frame can be copied right from the model
+    observerId = model->subscribe([this](const GameModel::Frame &, GameModel::Event){ publish(); });
+    model->setMinimap(&minimap);
+
+    //the thread object lives on the GUI thread, so its signal arrives as an event of this thread's loop
+    connect(thread, SIGNAL(commandsPosted()), this, SLOT(processCommands()), Qt::QueuedConnection);
+    //commands posted before the connection was made woke nobody
+    QMetaObject::invokeMethod(this, "processCommands", Qt::QueuedConnection);
+}
+
+SimulationWorker::~SimulationWorker(){
+    model->unsubscribe(observerId);
+    model->setMinimap(0);
+}
+
+
+//Copies the current frame of the model into the triple buffer and hands it over to the GUI thread.
+void SimulationWorker::publish(){
+    GameModel::Frame &back = thread->frames.backBuffer();
+    copyFrame(back, model->currentFrame());
+    back.paused = model->gamePaused();
+    thread->frames.publish();
+}
+
+
+//Passes every queued command to the model, in the order the user gave them, and the time scale if it has changed.
+//The wake-up is cleared before the queue is read, so a command posted after the last pop wakes the thread again.
+void SimulationWorker::processCommands(){
+    thread->wakePending.fetchAndStoreOrdered(0);
+    int scale = thread->timeScale.loadAcquire();
+    if (scale != appliedTimeScale){
+        appliedTimeScale = scale;
+        model->setTimeScale(scale / 256.0);
+    }
+    GameModel::Command c;
+    bool paused = model->gamePaused();
+    while (thread->commands.pop(c)){
+        model->queueCommand(c);
+    }
+    //pausing doesn't change the table, so the View has to be told separately
+    if (paused != model->gamePaused()) publish();
+}
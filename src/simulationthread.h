@@ -0,0 +1,89 @@
+#ifndef SIMULATIONTHREAD_H
+#define SIMULATIONTHREAD_H
+
+#include <QThread>
+#include <QAtomicInt>
+#include "gamemodel.h"
+#include "triplebuffer.h"
+#include "spscqueue.h"
+#include "minimap.h"
+
+//Runs a GameModel (and its timers) on a dedicated thread, so that the simulation doesn't have to share
+//the event loop of the GUI thread.
+//The state of the game is handed to the View through a triple buffer, and the user's input travels back
+//through a single-producer/single-consumer queue, so neither thread ever blocks the other. The simulation thread
+//sleeps until a command is posted (see commandsPosted) or its model's clock is due.
+class SimulationThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    SimulationThread(int size, int wallnum, int enemynum, int enemyspd, bool destroywalls, int playerspd, double timescale = 1.0, QObject *parent = 0);
+    ~SimulationThread();
+
+    //-----called from the GUI thread-----
+    //returns false if the input queue is full and the command was dropped
+    bool postCommand(const GameModel::Command &c);
+    //returns true if a new frame was published since the last call; it can be read with frame()
+    bool fetchFrame();
+    const GameModel::Frame& frame() const {return frames.frontBuffer();}
+    int publishedFrames() const {return frames.publishedCount();}
+    //streams the game to spectators through a local socket of this name (must be set before start())
+    void setSpectatorServer(const QString &name) {spectatorName = name;}
+    //records the game into this file (must be set before start())
+    void setRecordFile(const QString &fileName) {recordFile = fileName;}
+    //speeds up or slows down the game (see GameModel::setTimeScale); taken by the thread when it wakes
+    void setTimeScale(double scale);
+    void stop();
+
+protected:
+    void run();
+
+private:
+    int _size;
+    int _wallnum;
+    int _enemynum;
+    int _enemyspd;
+    bool _destroywalls;
+    int _playerspd;
+    QString spectatorName;
+    QString recordFile;
+
+    TripleBuffer<GameModel::Frame> frames;
+    SpscQueue<GameModel::Command, 64> commands;
+    QAtomicInt wakePending; //commandsPosted was emitted, and the worker hasn't drained the queue since
+    QAtomicInt timeScale; //the time scale the game should run at, in 1/256ths
+
+    friend class SimulationWorker;
+
+signals:
+    //wakes the worker on the simulation thread (a queued connection); emitted only once until the worker drains
+    //the queue, so a burst of commands (or time scale changes) posts a single event
+    void commandsPosted();
+};
+
+
+//Lives on the simulation thread: publishes the model's frame whenever the model changes (it observes the model
+//directly, see GameModel::subscribe), and feeds the queued commands to the model.
+class SimulationWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    SimulationWorker(GameModel *m, SimulationThread *t);
+    ~SimulationWorker();
+
+private:
+    GameModel* model;
+    SimulationThread* thread;
+    int observerId;
+    int appliedTimeScale; //the time scale of the thread last given to the model
+    MinimapPyramid minimap; //its overview goes into the frames
+
+    void publish();
+
+private slots:
+    void processCommands();
+};
+
+#endif // SIMULATIONTHREAD_H
@@ -0,0 +1,101 @@
+#include "spectatorpublisher.h"
+#include <QDebug>
+
+SpectatorPublisher::SpectatorPublisher(GameModel *m, const QString &serverName, QObject *parent):
+    QObject(parent), model(m), skipped(0)
+{
+    status.bombedEnemies = 0;
+    status.gameTime = 0;
+    status.airstrike = false;
+    status.countdown = 0;
+    status.paused = false;
+    status.ended = false;
+    status.playerWon = false;
+
+    //a server left behind by a crashed instance would block the name
+    QLocalServer::removeServer(serverName);
+    listening = server.listen(serverName);
+    if (!listening) qDebug() << "spectator server" << serverName << "couldn't start:" << server.errorString();
+    connect(&server, SIGNAL(newConnection()), this, SLOT(subscriberConnected()));
+
+    connect(model, SIGNAL(tableChanged(QVector<QVector<GameModel::TileType> >,GameModel::Position,QVector<GameModel::Position>)),
+            this, SLOT(gameModel_tableChanged()));
+    connect(model, SIGNAL(statusChanged(int,int,bool,int)), this, SLOT(gameModel_statusChanged(int,int,bool,int)));
+    connect(model, SIGNAL(gameEnded(bool)), this, SLOT(gameModel_gameEnded(bool)));
+
+    //the changes reported by the model in one go (see GameModel::clockTimeout) are sent as one tick
+    publishTimer.setSingleShot(true);
+    publishTimer.setInterval(0);
+    connect(&publishTimer, SIGNAL(timeout()), this, SLOT(publish()));
+}
+
+SpectatorPublisher::~SpectatorPublisher(){
+    foreach(const Subscriber &s, subscribers) delete s.socket;
+}
+
+
+void SpectatorPublisher::gameModel_tableChanged(){
+    if (!subscribers.isEmpty()) publishTimer.start();
+}
+
+
+void SpectatorPublisher::gameModel_statusChanged(const int eNumber, const int tCounter, const bool airstrike, const int countdown){
+    status.bombedEnemies = eNumber;
+    status.gameTime = tCounter;
+    status.airstrike = airstrike;
+    status.countdown = countdown;
+    if (!subscribers.isEmpty()) publishTimer.start();
+}
+
+
+void SpectatorPublisher::gameModel_gameEnded(const bool playerWon){
+    status.ended = true;
+    status.playerWon = playerWon;
+    if (!subscribers.isEmpty()) publishTimer.start();
+}
+
+
+void SpectatorPublisher::subscriberConnected(){
+    while (server.hasPendingConnections()){
+        Subscriber s;
+        s.socket = server.nextPendingConnection();
+        s.needsKeyframe = true;
+        connect(s.socket, SIGNAL(disconnected()), this, SLOT(subscriberDisconnected()));
+        subscribers.append(s);
+    }
+    publishTimer.start();
+}
+
+
+void SpectatorPublisher::subscriberDisconnected(){
+    for (int i = 0; i < subscribers.size(); i++){
+        if (subscribers[i].socket == sender()){
+            subscribers[i].socket->deleteLater();
+            subscribers.removeAt(i);
+            return;
+        }
+    }
+}
+
+
+//Encodes the current tick straight from the model, and sends it to every spectator that can take it.
+void SpectatorPublisher::publish(){
+    //a new game has begun since the end of the last one
+    if (status.ended && !model->getPlayerDied() && !model->enemiesRef().isEmpty()) status.ended = false;
+    status.paused = model->gamePaused();
+    encoder.encode(model->tableRef(), model->getPlayer(), model->enemiesRef(), status);
+
+    for (int i = 0; i < subscribers.size(); i++){
+        Subscriber &s = subscribers[i];
+        if (s.socket->bytesToWrite() > maxBacklog){
+            //too far behind: the deltas it misses make it wait for a keyframe
+            s.needsKeyframe = true;
+            skipped++;
+        } else if (s.needsKeyframe){
+            s.socket->write(encoder.keyframe());
+            s.needsKeyframe = false;
+        } else {
+            s.socket->write(encoder.delta());
+        }
+    }
+}
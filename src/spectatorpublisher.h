@@ -0,0 +1,56 @@
+#ifndef SPECTATORPUBLISHER_H
+#define SPECTATORPUBLISHER_H
+
+#include <QObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTimer>
+#include "gamemodel.h"
+#include "framecodec.h"
+
+//Streams a game to any number of spectators over a local socket (see framecodec.h for the format).
+//A new spectator gets a keyframe, then a delta for every tick. Each tick is encoded once, no matter how many
+//spectators there are. A spectator that can't keep up is not waited for: while its unsent data is over
+//'maxBacklog', it gets nothing, and once it has caught up, it continues with a keyframe.
+//The publisher must live on the thread of the model.
+class SpectatorPublisher : public QObject
+{
+    Q_OBJECT
+
+public:
+    SpectatorPublisher(GameModel *m, const QString &serverName, QObject *parent = 0);
+    ~SpectatorPublisher();
+
+    bool isListening() const {return listening;}
+    int subscriberCount() const {return subscribers.size();}
+    int publishedTicks() const {return int(encoder.tick());}
+    //the messages not sent to slow spectators
+    int skippedMessages() const {return skipped;}
+
+    static const qint64 maxBacklog = 256 * 1024;
+
+private:
+    struct Subscriber{
+        QLocalSocket* socket;
+        bool needsKeyframe;
+    };
+
+    GameModel* model;
+    QLocalServer server;
+    bool listening;
+    QList<Subscriber> subscribers;
+    FrameEncoder encoder;
+    FrameStatus status;
+    QTimer publishTimer;
+    int skipped;
+
+private slots:
+    void gameModel_tableChanged();
+    void gameModel_statusChanged(const int eNumber, const int tCounter, const bool airstrike, const int countdown);
+    void gameModel_gameEnded(const bool playerWon);
+    void subscriberConnected();
+    void subscriberDisconnected();
+    void publish();
+};
+
+#endif // SPECTATORPUBLISHER_H
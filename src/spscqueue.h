@@ -0,0 +1,44 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <QAtomicInt>
+
+//Fixed size, lock-free queue for exactly one producer thread and one consumer thread.
+//'Capacity' has to be a power of two; one slot is always kept empty to tell a full queue from an empty one.
+template <typename T, int Capacity>
+class SpscQueue
+{
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    //producer side: returns false (and drops the item) if the queue is full
+    bool push(const T& item){
+        int t = tail.load();
+        int next = (t + 1) & (Capacity - 1);
+        if (next == head.loadAcquire()) return false;
+        items[t] = item;
+        tail.storeRelease(next);
+        return true;
+    }
+
+    //consumer side: returns false if there was nothing to take
+    bool pop(T& item){
+        int h = head.load();
+        if (h == tail.loadAcquire()) return false;
+        item = items[h];
+        head.storeRelease((h + 1) & (Capacity - 1));
+        return true;
+    }
+
+    bool isEmpty() const {return head.loadAcquire() == tail.loadAcquire();}
+
+private:
+    T items[Capacity];
+    QAtomicInt head; //next slot to read, written only by the consumer
+    QAtomicInt tail; //next slot to write, written only by the producer
+
+    SpscQueue(const SpscQueue&);
+    SpscQueue& operator=(const SpscQueue&);
+};
+
+#endif // SPSCQUEUE_H
@@ -0,0 +1,108 @@
+#include "tileheatmap.h"
+#include "framecodec.h"
+
+static const char heatmapMagic[] = "BMHM";
+static const quint8 formatVersion = 1;
+
+
+TileHeatmap::TileHeatmap(int size):
+    n(0)
+{
+    resize(size);
+}
+
+
+void TileHeatmap::resize(int size){
+    n = qMax(0, size);
+    for (int c = 0; c < counterKinds; c++) counts[c].resize(n * n);
+    clear();
+}
+
+
+void TileHeatmap::clear(){
+    for (int c = 0; c < counterKinds; c++) counts[c].fill(0);
+}
+
+
+void TileHeatmap::blastHit(int x, int y, const BlastStencil &stencil){
+    quint64* hits = counts[BlastHits].data();
+    foreach (const BlastStencil::Span &s, stencil.spans()){
+        int i = x + s.dx;
+        if (i < 1 || i > n - 2) continue;
+        for (int j = qMax(y + s.left, 1); j <= qMin(y + s.right, n - 2); j++) hits[i*n + j]++;
+    }
+}
+
+
+quint64 TileHeatmap::total(Counter c) const{
+    quint64 sum = 0;
+    const quint64* d = counts[c].constData();
+    for (int k = 0; k < n * n; k++) sum += d[k];
+    return sum;
+}
+
+
+bool TileHeatmap::merge(const TileHeatmap &other){
+    if (other.n != n) return false;
+    for (int c = 0; c < counterKinds; c++){
+        quint64* to = counts[c].data();
+        const quint64* from = other.counts[c].constData();
+        for (int k = 0; k < n * n; k++) to[k] += from[k];
+    }
+    return true;
+}
+
+
+//Most tiles have small counts (or none), so the varints keep the file a fraction of the size of fixed-width counters.
+bool TileHeatmap::writeBinary(QIODevice &device) const{
+    QByteArray out;
+    out.reserve(16 + counterKinds * n * n * 2);
+    out.append(heatmapMagic, 4);
+    out.append(char(formatVersion));
+    appendVarint(out, n);
+    for (int c = 0; c < counterKinds; c++){
+        const quint64* d = counts[c].constData();
+        for (int k = 0; k < n * n; k++) appendVarint(out, d[k]);
+    }
+    return device.write(out) == out.size();
+}
+
+
+//Replaces the counters with the ones read; on failure, the heatmap is left empty.
+bool TileHeatmap::readBinary(QIODevice &device){
+    resize(0);
+    QByteArray in = device.readAll();
+    const char* p = in.constData();
+    const char* end = p + in.size();
+    quint64 size;
+    if (in.size() < 5 || qstrncmp(p, heatmapMagic, 4) != 0 || quint8(p[4]) != formatVersion) return false;
+    p += 5;
+    if (!readVarint(p, end, size) || size > 4096) return false;
+    resize(int(size));
+    for (int c = 0; c < counterKinds; c++){
+        quint64* d = counts[c].data();
+        for (int k = 0; k < n * n; k++){
+            if (!readVarint(p, end, d[k])) {
+                resize(0);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+bool TileHeatmap::writeCsv(QIODevice &device, Counter c) const{
+    QByteArray line;
+    const quint64* d = counts[c].constData();
+    for (int i = 0; i < n; ++i){
+        line.resize(0);
+        for (int j = 0; j < n; ++j){
+            if (j > 0) line.append(',');
+            line.append(QByteArray::number(d[i*n + j]));
+        }
+        line.append('\n');
+        if (device.write(line) != line.size()) return false;
+    }
+    return true;
+}
@@ -0,0 +1,48 @@
+#ifndef TILEHEATMAP_H
+#define TILEHEATMAP_H
+
+#include <QVector>
+#include <QIODevice>
+#include "blaststencil.h"
+
+//Counts, for every tile of a board, how often the player died there, an enemy was killed there,
+//and a blast hit it, over any number of games (for balancing the levels).
+//It is filled by a GameModel (see GameModel::setHeatmap) or by the workers of a BatchEnvironment,
+//and heatmaps of the same size are added up with merge(). A heatmap is not thread safe, and doesn't need to be:
+//every thread fills its own, with plain increments, and they are only merged at the end.
+//
+//The binary form is the magic "BMHM", a version byte, then varints: the size, and the counters of each kind
+//(in the order of Counter), row after row. The CSV form is one kind of counter as a grid, a line per row.
+class TileHeatmap
+{
+public:
+    enum Counter { PlayerDeaths, EnemyKills, BlastHits };
+    static const int counterKinds = 3;
+
+    explicit TileHeatmap(int size = 0);
+
+    //sets the size, and zeroes the counters
+    void resize(int size);
+    void clear();
+    int size() const {return n;}
+
+    void playerDied(int x, int y) {counts[PlayerDeaths][x*n + y]++;}
+    void enemyKilled(int x, int y) {counts[EnemyKills][x*n + y]++;}
+    //the tiles stamped by a blast around (x,y): the inner tiles only, like BlastKernel::apply
+    void blastHit(int x, int y, const BlastStencil &stencil);
+
+    quint64 count(Counter c, int x, int y) const {return counts[c][x*n + y];}
+    quint64 total(Counter c) const;
+    //adds the counters of 'other' to these; returns false (and adds nothing) if the sizes differ
+    bool merge(const TileHeatmap &other);
+
+    bool writeBinary(QIODevice &device) const;
+    bool readBinary(QIODevice &device);
+    bool writeCsv(QIODevice &device, Counter c) const;
+
+private:
+    int n;
+    QVector<quint64> counts[counterKinds];
+};
+
+#endif // TILEHEATMAP_H
@@ -0,0 +1,59 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <QAtomicInt>
+
+//Lock-free handoff of the latest value from one producer thread to one consumer thread.
+//The producer fills its back buffer and publishes it by swapping it with the middle buffer,
+//the consumer takes the middle buffer by swapping it with its front buffer.
+//Neither side ever waits for the other: if the consumer is slow, older values are simply overwritten.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : middle(1), published(0), back(2), front(0) {}
+
+    //-----producer side-----
+
+    //the buffer the producer may freely write into
+    T& backBuffer() {return buffers[back];}
+
+    //makes the back buffer the newest available value
+    void publish(){
+        back = middle.fetchAndStoreAcqRel(back | FreshBit) & IndexMask;
+        published.fetchAndAddRelease(1);
+    }
+
+    //-----consumer side-----
+
+    //takes the newest published value, if there is one that hasn't been taken yet
+    //returns false if nothing was published since the last call
+    bool update(){
+        if ( !(middle.loadAcquire() & FreshBit) ) return false;
+        front = middle.fetchAndStoreAcqRel(front) & IndexMask;
+        return true;
+    }
+
+    //true if a value was published that update() hasn't taken yet
+    bool hasFresh() const {return middle.loadAcquire() & FreshBit;}
+
+    //the value taken by the last successful update()
+    const T& frontBuffer() const {return buffers[front];}
+
+    //the number of values published so far; can be read from either side
+    int publishedCount() const {return published.loadAcquire();}
+
+private:
+    enum { IndexMask = 3, FreshBit = 4 };
+
+    T buffers[3];
+    QAtomicInt middle; //index of the middle buffer, plus FreshBit if it holds an unread value
+    QAtomicInt published;
+    int back;          //owned by the producer
+    int front;         //owned by the consumer
+
+    TripleBuffer(const TripleBuffer&);
+    TripleBuffer& operator=(const TripleBuffer&);
+};
+
+#endif // TRIPLEBUFFER_H
@@ -0,0 +1,125 @@
+#include "winestimator.h"
+#include <QThread>
+
+//the first action of the playouts of each block
+static const quint8 firstActions[5] = {BatchEnvironment::Stay, BatchEnvironment::MoveUp, BatchEnvironment::MoveRight,
+                                       BatchEnvironment::MoveDown, BatchEnvironment::MoveLeft};
+
+
+WinEstimator::WinEstimator(int playoutsPerAction, int horizon, int threads):
+    _playouts(qMax(1, playoutsPerAction)), _horizon(horizon),
+    _threads(threads > 0 ? threads : qMax(1, QThread::idealThreadCount() - 1)),
+    running(0), stopping(0), env(0), seeds(1)
+{
+    job.owner = this;
+    job.setAutoDelete(false);
+    pool.setMaxThreadCount(1);
+}
+
+//Waits for the playouts running, which stop at their next step.
+WinEstimator::~WinEstimator(){
+    stopping.storeRelease(1);
+    pool.waitForDone();
+    delete env;
+}
+
+
+//Starts the job unless it is running: then it finds the state when its current estimate is done.
+void WinEstimator::submit(const GameModel::Params &params, const GameModel::State &state){
+    Request &r = requests.backBuffer();
+    r.params = params;
+    r.state = state;
+    requests.publish();
+    if (running.testAndSetOrdered(0, 1)) pool.start(&job);
+}
+
+
+//The body of the job: estimates the newest state, until there is no newer one.
+//A state handed over just as the job was finishing starts it again (here or in submit, whichever gets there first).
+void WinEstimator::work(){
+    do {
+        while (requests.update() && !stopping.loadAcquire()){
+            const Request &r = requests.frontBuffer();
+            compute(r.params, r.state, seeds, estimates.backBuffer());
+            seeds += 5 * _playouts;
+            estimates.publish();
+        }
+        running.storeRelease(0);
+    } while (requests.hasFresh() && !stopping.loadAcquire() && running.testAndSetOrdered(0, 1));
+}
+
+
+//Each first action gets 'playoutsPerAction' playouts of at most 'horizon' steps. A playout ends at the end of
+//its game (the environment starts a new one there, which is ignored).
+void WinEstimator::compute(const GameModel::Params &params, const GameModel::State &state, quint32 seed, Estimate &out){
+    out.valid = false;
+    out.winChance = 0;
+    for (int a = 0; a < 5; a++) out.risk[a] = 0;
+    out.playouts = 0;
+    out.gameTime = state.gameTime;
+    if (state.playerDied || state.enemies.isEmpty()) return;
+
+    bool sameRules = env && env->params().size == params.size && env->params().enemynum == params.enemynum &&
+                     env->params().enemyspd == params.enemyspd && env->params().destroywalls == params.destroywalls;
+    if (!sameRules){
+        delete env;
+        env = new BatchEnvironment(5 * _playouts, params, _threads);
+        actions.resize(env->count());
+        alive.resize(env->count());
+    }
+    int n = env->count();
+    for (int e = 0; e < n; e++){
+        if (!env->loadState(e, state, seed + e)) return;
+        alive[e] = 1;
+    }
+
+    int remaining = n;
+    int deaths[5] = {0, 0, 0, 0, 0};
+    double wins = 0;
+    for (int step = 0; step < _horizon && remaining > 0 && !stopping.loadAcquire(); step++){
+        bot.actAll(*env, actions.data());
+        if (step == 0){
+            for (int e = 0; e < n; e++) actions[e] = firstActions[e / _playouts];
+        }
+        BatchEnvironment::StepResult r = env->step(actions.constData());
+        for (int e = 0; e < n; e++){
+            if (!alive[e] || !r.dones[e]) continue;
+            alive[e] = 0;
+            remaining--;
+            if (r.wins[e]) wins += 1;
+            else deaths[e / _playouts]++;
+        }
+    }
+    int enemies = state.enemies.size();
+    for (int e = 0; e < n; e++){
+        if (alive[e]) wins += double(enemies - env->enemyCount(e)) / enemies;
+    }
+
+    out.valid = true;
+    out.winChance = wins / n;
+    for (int a = 0; a < 5; a++) out.risk[a] = double(deaths[a]) / _playouts;
+    out.playouts = n;
+}
+
+
+void WinEstimator::stateFromFrame(const GameModel::Frame &f, GameModel::State &s){
+    int size = f.table.size();
+    s.tick = 0;
+    s.tiles.resize(size * size);
+    for (int i = 0; i < size; ++i){
+        const GameModel::TileType* row = f.table[i].constData();
+        for (int j = 0; j < size; ++j) s.tiles[i*size + j] = quint8(row[j]);
+    }
+    s.player = f.player;
+    s.enemies = f.enemies;
+    s.randomState = 1;
+    s.gameTime = f.gameTime;
+    s.explosionDelay = f.countdown;
+    s.waitingForExplosion = f.airstrike;
+    s.target = f.target;
+    s.playerDied = f.ended && !f.playerWon;
+    s.gameClock = 0;
+    s.nextEnemyStep = 0;
+    s.nextSecond = 0;
+    s.nextInput = 0;
+}
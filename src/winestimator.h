@@ -0,0 +1,80 @@
+#ifndef WINESTIMATOR_H
+#define WINESTIMATOR_H
+
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
+#include "gamemodel.h"
+#include "triplebuffer.h"
+#include "batchenvironment.h"
+#include "referencebot.h"
+
+//Estimates the player's chance to win, and the risk of each move, by Monte Carlo playouts: copies of the current
+//state of the game are played on for a short while in a BatchEnvironment, the first step with each move and the
+//rest by a ReferenceBot (the enemies' turns make each playout different).
+//The View hands over the newest state every few ticks with submit(), and picks up the newest estimate with
+//fetchEstimate(); the playouts run on a pool of their own in between. Both directions go through triple buffers,
+//so neither side waits for the other: states handed over while the playouts are busy replace each other,
+//and only the last one is estimated.
+class WinEstimator
+{
+public:
+    struct Estimate{
+        bool valid;
+        double winChance;   //the share of the playouts won, the unfinished ones counted by the share of enemies killed
+        double risk[5];     //the share of the playouts lost, by first action (BatchEnvironment::Stay to MoveLeft)
+        int playouts;
+        int gameTime;       //of the state it was made from
+    };
+
+    //'threads' == 0 leaves one core for the game and the GUI
+    explicit WinEstimator(int playoutsPerAction = 200, int horizon = 120, int threads = 0);
+    ~WinEstimator();
+
+    //-----called from the View's thread-----
+    void submit(const GameModel::Params &params, const GameModel::State &state);
+    //returns true if an estimate was made since the last call; it can be read with estimate()
+    bool fetchEstimate() {return estimates.update();}
+    const Estimate& estimate() const {return estimates.frontBuffer();}
+    int finishedEstimates() const {return estimates.publishedCount();}
+
+    //plays out 'state' on the calling thread; the seeds of the playouts come from 'seed'
+    void compute(const GameModel::Params &params, const GameModel::State &state, quint32 seed, Estimate &out);
+
+    //the state of a frame published by a model (see GameModel::Frame), without the model's random sequence and clock
+    static void stateFromFrame(const GameModel::Frame &f, GameModel::State &s);
+
+private:
+    struct Request{
+        GameModel::Params params;
+        GameModel::State state;
+    };
+
+    class Job : public QRunnable
+    {
+    public:
+        WinEstimator* owner;
+        void run() {owner->work();}
+    };
+
+    int _playouts;
+    int _horizon;
+    int _threads;
+    TripleBuffer<Request> requests;
+    TripleBuffer<Estimate> estimates;
+    QThreadPool pool;
+    Job job;
+    QAtomicInt running;  //the job is on the pool
+    QAtomicInt stopping;
+
+    //used by the job only
+    BatchEnvironment* env;
+    ReferenceBot bot;
+    QVector<quint8> actions;
+    QVector<quint8> alive;
+    quint32 seeds;
+
+    void work();
+};
+
+#endif // WINESTIMATOR_H